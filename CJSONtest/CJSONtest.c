@@ -8,6 +8,23 @@
 #include "cJSON.h"
 #include "app_weather.h"
 
+// parse_weather looks up about 20 keys in each of these objects, index them so that every lookup is O(1)
+static void index_forecast(cJSON* json)
+{
+	const char* arrays[] = { "hourly", "daily" };
+	cJSON* entry = NULL;
+
+	cJSON_IndexObject(json);
+	cJSON_IndexObject(cJSON_GetObjectItemCaseSensitive(json, "current"));
+	for (int i = 0; i < 2; i++)
+	{
+		cJSON_ArrayForEach(entry, cJSON_GetObjectItemCaseSensitive(json, arrays[i]))
+		{
+			cJSON_IndexObject(entry);
+		}
+	}
+}
+
 int main()
 {
 	const char* filename = "weather.json";
@@ -48,7 +65,8 @@ int main()
 		wprintf(L"%s\n", buf);
 	*/
 
-	cJSON* json = cJSON_Parse(buffer);
+	// buffer lives until exit, so the strings can stay in it instead of being copied
+	cJSON* json = cJSON_ParseInPlace(buffer, (size_t)bytes_read);
 	const char* error_ptr = cJSON_GetErrorPtr();
 	if (error_ptr != NULL)
 	{
@@ -59,6 +77,7 @@ int main()
 
 	weather_info_t weather;
 
+	index_forecast(json);
 	parse_weather(json, &weather);
 	
 	print_weather(&weather);
@@ -49,6 +49,37 @@
 #include <locale.h>
 #endif
 
+/* SSE2 is part of every x86-64 CPU (and of MSVC's default x86 target), AVX2 is detected at runtime.
+ * Define CJSON_DISABLE_SIMD to only use the portable scalar code. */
+#if !defined(CJSON_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#define CJSON_SIMD_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER) || (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))) || defined(__clang__)
+#define CJSON_SIMD_AVX2
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+/* cJSON_ParseLines parses everything on the calling thread unless CJSON_ENABLE_THREADS is defined, then it
+ * uses worker threads (Win32 threads, or pthreads which need linking with -pthread). */
+#if defined(CJSON_ENABLE_THREADS)
+#if defined(_WIN32)
+#define CJSON_THREADS_WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <process.h>
+#else
+#define CJSON_THREADS_PTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#endif
+
 #if defined(_MSC_VER)
 #pragma warning (pop)
 #endif
@@ -85,11 +116,41 @@
 #endif
 #endif
 
+/* 64 bit unsigned integer for number parsing and printing and the structural index of cJSON_ParseFast.
+ * C89 has no long long, so use unsigned long where it is wide enough and the compiler's own type otherwise.
+ * CJSON_UINT64_C makes a constant of that type. */
+#if ULONG_MAX > 0xFFFFFFFFUL
+typedef unsigned long cjson_uint64;
+#define CJSON_UINT64_C(value) value##UL
+#elif defined(_MSC_VER)
+typedef unsigned __int64 cjson_uint64;
+#define CJSON_UINT64_C(value) value##ui64
+#elif defined(__GNUC__) && !(defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 199901L))
+__extension__ typedef unsigned long long cjson_uint64;
+#define CJSON_UINT64_C(value) (__extension__ value##ULL)
+#else
+typedef unsigned long long cjson_uint64;
+#define CJSON_UINT64_C(value) value##ULL
+#endif
+
+/* global_error is kept per thread where the compiler supports it, so that threads parsing at the same time
+ * don't overwrite each other's error. */
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+#define CJSON_THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+#define CJSON_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#define CJSON_THREAD_LOCAL __thread
+#else
+#define CJSON_THREAD_LOCAL
+#endif
+
 typedef struct {
     const unsigned char *json;
     size_t position;
+    int reason; /* cJSON_ParseError... */
 } error;
-static error global_error = { NULL, 0 };
+static CJSON_THREAD_LOCAL error global_error = { NULL, 0, 0 };
 
 CJSON_PUBLIC(const char *) cJSON_GetErrorPtr(void)
 {
@@ -117,7 +178,7 @@ CJSON_PUBLIC(double) cJSON_GetNumberValue(const cJSON * const item)
 }
 
 /* This is a safeguard to prevent copy-pasters from using incompatible C and header files */
-#if (CJSON_VERSION_MAJOR != 1) || (CJSON_VERSION_MINOR != 7) || (CJSON_VERSION_PATCH != 18)
+#if (CJSON_VERSION_MAJOR != 1) || (CJSON_VERSION_MINOR != 8) || (CJSON_VERSION_PATCH != 0)
     #error cJSON.h and cJSON.c have different versions. Make sure that both have the same.
 #endif
 
@@ -153,37 +214,92 @@ static int case_insensitive_strcmp(const unsigned char *string1, const unsigned
     return tolower(*string1) - tolower(*string2);
 }
 
+/* The hooks take the user pointer of a cJSON_Context, the global ones go through wrappers. */
 typedef struct internal_hooks
 {
-    void *(CJSON_CDECL *allocate)(size_t size);
-    void (CJSON_CDECL *deallocate)(void *pointer);
-    void *(CJSON_CDECL *reallocate)(void *pointer, size_t size);
+    void *(CJSON_CDECL *allocate)(void *user_data, size_t size);
+    void (CJSON_CDECL *deallocate)(void *user_data, void *pointer);
+    void *(CJSON_CDECL *reallocate)(void *user_data, void *pointer, size_t size);
+    void *user_data;
+    struct cJSON_Slab *slab; /* if not NULL, nodes come from here */
 } internal_hooks;
 
-#if defined(_MSC_VER)
-/* work around MSVC error C2322: '...' address of dllimport '...' is not static */
-static void * CJSON_CDECL internal_malloc(size_t size)
+static void * CJSON_CDECL internal_malloc(void *user_data, size_t size)
 {
+    (void)user_data;
     return malloc(size);
 }
-static void CJSON_CDECL internal_free(void *pointer)
+static void CJSON_CDECL internal_free(void *user_data, void *pointer)
 {
+    (void)user_data;
     free(pointer);
 }
-static void * CJSON_CDECL internal_realloc(void *pointer, size_t size)
+static void * CJSON_CDECL internal_realloc(void *user_data, void *pointer, size_t size)
 {
+    (void)user_data;
     return realloc(pointer, size);
 }
-#else
-#define internal_malloc malloc
-#define internal_free free
-#define internal_realloc realloc
-#endif
+
+/* the functions given to cJSON_InitHooks */
+static cJSON_Hooks user_hooks = { NULL, NULL };
+
+static void * CJSON_CDECL user_malloc(void *user_data, size_t size)
+{
+    (void)user_data;
+    return user_hooks.malloc_fn(size);
+}
+static void CJSON_CDECL user_free(void *user_data, void *pointer)
+{
+    (void)user_data;
+    user_hooks.free_fn(pointer);
+}
 
 /* strlen of character literals resolved at compile time */
 #define static_strlen(string_literal) (sizeof(string_literal) - sizeof(""))
 
-static internal_hooks global_hooks = { internal_malloc, internal_free, internal_realloc };
+static internal_hooks global_hooks = { internal_malloc, internal_free, internal_realloc, NULL, NULL };
+
+/* Nodes don't know their parent, so a change deep in a tree can't forget the hashes memoized by
+ * cJSON_MemoizeHash on the way to the root. Instead every change through the cJSON functions starts a new
+ * epoch and a memo only counts in the epoch it was taken in. Trees on different threads may change at the
+ * same time, so this takes atomics, without them nothing is memoized. Nothing is counted before the first
+ * memo exists. */
+#if defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7))))
+#define CJSON_HASH_MEMOS
+static long tree_epoch = 0;
+static int hashes_memoized = 0;
+#define atomic_load_relaxed(variable) __atomic_load_n(&(variable), __ATOMIC_RELAXED)
+#define atomic_set(variable) __atomic_store_n(&(variable), 1, __ATOMIC_RELAXED)
+#define atomic_increment(variable) ((void)__atomic_add_fetch(&(variable), 1, __ATOMIC_RELAXED))
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define CJSON_HASH_MEMOS
+/* aligned volatile longs are read in one piece */
+static volatile long tree_epoch = 0;
+static volatile long hashes_memoized = 0;
+#define atomic_load_relaxed(variable) (variable)
+#define atomic_set(variable) ((void)_InterlockedExchange(&(variable), 1))
+#define atomic_increment(variable) ((void)_InterlockedIncrement(&(variable)))
+#endif
+
+static void trees_changed(void)
+{
+#if defined(CJSON_HASH_MEMOS)
+    if (atomic_load_relaxed(hashes_memoized))
+    {
+        atomic_increment(tree_epoch);
+    }
+#endif
+}
+
+static long current_tree_epoch(void)
+{
+#if defined(CJSON_HASH_MEMOS)
+    return atomic_load_relaxed(tree_epoch);
+#else
+    return 0;
+#endif
+}
 
 static unsigned char* cJSON_strdup(const unsigned char* string, const internal_hooks * const hooks)
 {
@@ -196,7 +312,7 @@ static unsigned char* cJSON_strdup(const unsigned char* string, const internal_h
     }
 
     length = strlen((const char*)string) + sizeof("");
-    copy = (unsigned char*)hooks->allocate(length);
+    copy = (unsigned char*)hooks->allocate(hooks->user_data, length);
     if (copy == NULL)
     {
         return NULL;
@@ -211,1651 +327,6031 @@ CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
     if (hooks == NULL)
     {
         /* Reset hooks */
-        global_hooks.allocate = malloc;
-        global_hooks.deallocate = free;
-        global_hooks.reallocate = realloc;
+        global_hooks.allocate = internal_malloc;
+        global_hooks.deallocate = internal_free;
+        global_hooks.reallocate = internal_realloc;
         return;
     }
 
-    global_hooks.allocate = malloc;
+    global_hooks.allocate = internal_malloc;
     if (hooks->malloc_fn != NULL)
     {
-        global_hooks.allocate = hooks->malloc_fn;
+        user_hooks.malloc_fn = hooks->malloc_fn;
+        global_hooks.allocate = user_malloc;
     }
 
-    global_hooks.deallocate = free;
+    global_hooks.deallocate = internal_free;
     if (hooks->free_fn != NULL)
     {
-        global_hooks.deallocate = hooks->free_fn;
+        user_hooks.free_fn = hooks->free_fn;
+        global_hooks.deallocate = user_free;
     }
 
     /* use realloc only if both free and malloc are used */
     global_hooks.reallocate = NULL;
-    if ((global_hooks.allocate == malloc) && (global_hooks.deallocate == free))
+    if ((global_hooks.allocate == internal_malloc) && (global_hooks.deallocate == internal_free))
     {
-        global_hooks.reallocate = realloc;
+        global_hooks.reallocate = internal_realloc;
     }
 }
 
-/* Internal constructor. */
-static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
+/* Node slab: nodes are taken from pages of nodes_per_page nodes and go back to a free list when they are
+ * deleted. The first node of a page is not handed out, its next links the pages. Pages are only given back
+ * when the slab is disabled. */
+/* a page of nodes */
+typedef struct
 {
-    cJSON* node = (cJSON*)hooks->allocate(sizeof(cJSON));
-    if (node)
+    cJSON *nodes;
+    size_t count;
+} cJSON_SlabPage;
+
+typedef struct cJSON_Slab
+{
+    /* sorted by address, which tells cJSON_Delete which nodes came from the slab */
+    cJSON_SlabPage *pages;
+    size_t page_capacity;
+    cJSON *free_list; /* linked through next */
+    size_t nodes_per_page;
+    size_t page_count;
+    size_t node_count; /* in all pages */
+    size_t nodes_in_use;
+} cJSON_Slab;
+
+#ifndef CJSON_SLAB_PAGE_NODES
+#define CJSON_SLAB_PAGE_NODES 256
+#endif
+
+static cJSON_Slab global_slab = { NULL, 0, NULL, 0, 0, 0, 0 };
+
+/* number of pages that start at or before node */
+static size_t slab_pages_before(const cJSON_Slab * const slab, const cJSON * const node)
+{
+    size_t low = 0;
+    size_t high = slab->page_count;
+
+    while (low < high)
     {
-        memset(node, '\0', sizeof(cJSON));
+        const size_t middle = low + ((high - low) / 2);
+        if (slab->pages[middle].nodes <= node)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
     }
 
-    return node;
+    return low;
 }
 
-/* Delete a cJSON structure. */
-CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
+/* whether node was taken from one of the pages of slab, which may be NULL */
+static cJSON_bool slab_owns(const cJSON_Slab * const slab, const cJSON * const node)
 {
-    cJSON *next = NULL;
-    while (item != NULL)
+    size_t position = 0;
+
+    if ((slab == NULL) || (slab->page_count == 0))
     {
-        next = item->next;
-        if (!(item->type & cJSON_IsReference) && (item->child != NULL))
+        return false;
+    }
+
+    position = slab_pages_before(slab, node);
+
+    return (position > 0) && (node < (slab->pages[position - 1].nodes + slab->pages[position - 1].count));
+}
+
+static cJSON *slab_allocate(cJSON_Slab * const slab, const internal_hooks * const hooks)
+{
+    cJSON *node = slab->free_list;
+
+    if (node == NULL)
+    {
+        cJSON *page = NULL;
+        size_t position = 0;
+        size_t i = 0;
+
+        if (slab->nodes_per_page >= ((~(size_t)0) / sizeof(cJSON)))
         {
-            cJSON_Delete(item->child);
+            return NULL;
         }
-        if (!(item->type & cJSON_IsReference) && (item->valuestring != NULL))
+        if (slab->page_count == slab->page_capacity)
         {
-            global_hooks.deallocate(item->valuestring);
-            item->valuestring = NULL;
+            const size_t capacity = (slab->page_capacity > 0) ? (slab->page_capacity * 2) : 16;
+            cJSON_SlabPage *pages = (cJSON_SlabPage*)hooks->allocate(hooks->user_data, capacity * sizeof(cJSON_SlabPage));
+            if (pages == NULL)
+            {
+                return NULL;
+            }
+            if (slab->pages != NULL)
+            {
+                memcpy(pages, slab->pages, slab->page_count * sizeof(cJSON_SlabPage));
+                hooks->deallocate(hooks->user_data, slab->pages);
+            }
+            slab->pages = pages;
+            slab->page_capacity = capacity;
         }
-        if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
+        page = (cJSON*)hooks->allocate(hooks->user_data, slab->nodes_per_page * sizeof(cJSON));
+        if (page == NULL)
         {
-            global_hooks.deallocate(item->string);
-            item->string = NULL;
+            return NULL;
         }
-        global_hooks.deallocate(item);
-        item = next;
+
+        /* keep the pages sorted, new ones mostly go to the end */
+        position = slab_pages_before(slab, page);
+        memmove(slab->pages + position + 1, slab->pages + position, (slab->page_count - position) * sizeof(cJSON_SlabPage));
+        slab->pages[position].nodes = page;
+        slab->pages[position].count = slab->nodes_per_page;
+        slab->page_count++;
+        slab->node_count += slab->nodes_per_page;
+        for (i = slab->nodes_per_page; i > 0; i--)
+        {
+            page[i - 1].next = slab->free_list;
+            slab->free_list = &page[i - 1];
+        }
+        node = slab->free_list;
     }
-}
 
-/* get the decimal point character of the current locale */
-static unsigned char get_decimal_point(void)
-{
-#ifdef ENABLE_LOCALES
-    struct lconv *lconv = localeconv();
-    return (unsigned char) lconv->decimal_point[0];
-#else
-    return '.';
-#endif
+    slab->free_list = node->next;
+    slab->nodes_in_use++;
+
+    return node;
 }
 
-typedef struct
+/* give back a chain of count nodes that is linked through next and ends in last */
+static void slab_free_chain(cJSON_Slab * const slab, cJSON * const first, cJSON * const last, const size_t count)
 {
-    const unsigned char *content;
-    size_t length;
-    size_t offset;
-    size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
-    internal_hooks hooks;
-} parse_buffer;
-
-/* check if the given size is left to read in a given parse buffer (starting with 1) */
-#define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
-/* check if the buffer can be accessed at the given index (starting with 0) */
-#define can_access_at_index(buffer, index) ((buffer != NULL) && (((buffer)->offset + index) < (buffer)->length))
-#define cannot_access_at_index(buffer, index) (!can_access_at_index(buffer, index))
-/* get a pointer to the buffer at the position */
-#define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
+    last->next = slab->free_list;
+    slab->free_list = first;
+    slab->nodes_in_use -= count;
+}
 
-/* Parse the input text to generate a number, and populate the result into item. */
-static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
+/* give all pages back, the slab must not have nodes in use */
+static void slab_release(cJSON_Slab * const slab, const internal_hooks * const hooks)
 {
-    double number = 0;
-    unsigned char *after_end = NULL;
-    unsigned char number_c_string[64];
-    unsigned char decimal_point = get_decimal_point();
     size_t i = 0;
 
-    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    for (i = 0; i < slab->page_count; i++)
     {
-        return false;
+        hooks->deallocate(hooks->user_data, slab->pages[i].nodes);
     }
-
-    /* copy the number into a temporary buffer and replace '.' with the decimal point
-     * of the current locale (for strtod)
-     * This also takes care of '\0' not necessarily being available for marking the end of the input */
-    for (i = 0; (i < (sizeof(number_c_string) - 1)) && can_access_at_index(input_buffer, i); i++)
+    if (slab->pages != NULL)
     {
-        switch (buffer_at_offset(input_buffer)[i])
-        {
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-            case '+':
-            case '-':
-            case 'e':
-            case 'E':
-                number_c_string[i] = buffer_at_offset(input_buffer)[i];
-                break;
+        hooks->deallocate(hooks->user_data, slab->pages);
+    }
+    slab->pages = NULL;
+    slab->page_capacity = 0;
+    slab->free_list = NULL;
+    slab->page_count = 0;
+    slab->node_count = 0;
+}
 
-            case '.':
-                number_c_string[i] = decimal_point;
-                break;
+/* Move the pages and free nodes of source into target, for slabs that were filled on other threads.
+ * Both use hooks. Returns false and leaves both alone if the merged page table can't be allocated. */
+static cJSON_bool slab_merge(cJSON_Slab * const target, cJSON_Slab * const source, const internal_hooks * const hooks)
+{
+    cJSON_SlabPage *pages = NULL;
+    cJSON *last = NULL;
+    size_t from_target = 0;
+    size_t from_source = 0;
+    size_t count = 0;
 
-            default:
-                goto loop_end;
-        }
+    if (source->page_count == 0)
+    {
+        /* nothing was allocated, so there are no free nodes either */
+        return true;
     }
-loop_end:
-    number_c_string[i] = '\0';
 
-    number = strtod((const char*)number_c_string, (char**)&after_end);
-    if (number_c_string == after_end)
+    pages = (cJSON_SlabPage*)hooks->allocate(hooks->user_data, (target->page_count + source->page_count) * sizeof(cJSON_SlabPage));
+    if (pages == NULL)
     {
-        return false; /* parse_error */
+        return false;
     }
-
-    item->valuedouble = number;
-
-    /* use saturation in case of overflow */
-    if (number >= INT_MAX)
+    while ((from_target < target->page_count) || (from_source < source->page_count))
     {
-        item->valueint = INT_MAX;
+        if ((from_source == source->page_count) || ((from_target < target->page_count) && (target->pages[from_target].nodes < source->pages[from_source].nodes)))
+        {
+            pages[count++] = target->pages[from_target++];
+        }
+        else
+        {
+            pages[count++] = source->pages[from_source++];
+        }
     }
-    else if (number <= (double)INT_MIN)
+    if (target->pages != NULL)
     {
-        item->valueint = INT_MIN;
+        hooks->deallocate(hooks->user_data, target->pages);
     }
-    else
+    hooks->deallocate(hooks->user_data, source->pages);
+    target->pages = pages;
+    target->page_capacity = count;
+
+    last = source->free_list;
+    if (last != NULL)
     {
-        item->valueint = (int)number;
+        while (last->next != NULL)
+        {
+            last = last->next;
+        }
+        last->next = target->free_list;
+        target->free_list = source->free_list;
     }
 
-    item->type = cJSON_Number;
+    target->page_count = count;
+    target->node_count += source->node_count;
+    target->nodes_in_use += source->nodes_in_use;
+    memset(source, '\0', sizeof(cJSON_Slab));
 
-    input_buffer->offset += (size_t)(after_end - number_c_string);
     return true;
 }
 
-/* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
-CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
+static cJSON_bool slab_enable(internal_hooks * const hooks, cJSON_Slab * const slab, size_t nodes_per_page)
 {
-    if (number >= INT_MAX)
-    {
-        object->valueint = INT_MAX;
-    }
-    else if (number <= (double)INT_MIN)
-    {
-        object->valueint = INT_MIN;
-    }
-    else
-    {
-        object->valueint = (int)number;
-    }
+    slab->nodes_per_page = (nodes_per_page != 0) ? nodes_per_page : CJSON_SLAB_PAGE_NODES;
+    hooks->slab = slab;
 
-    return object->valuedouble = number;
+    return true;
 }
 
-/* Note: when passing a NULL valuestring, cJSON_SetValuestring treats this as an error and return NULL */
-CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
+static cJSON_bool slab_disable(internal_hooks * const hooks, cJSON_Slab * const slab)
 {
-    char *copy = NULL;
-    size_t v1_len;
-    size_t v2_len;
-    /* if object's type is not cJSON_String or is cJSON_IsReference, it should not set valuestring */
-    if ((object == NULL) || !(object->type & cJSON_String) || (object->type & cJSON_IsReference))
+    if (slab->nodes_in_use != 0)
     {
-        return NULL;
+        return false;
     }
-    /* return NULL if the object is corrupted or valuestring is NULL */
-    if (object->valuestring == NULL || valuestring == NULL)
+
+    hooks->slab = NULL;
+    slab_release(slab, hooks);
+
+    return true;
+}
+
+static void slab_stats(const cJSON_Slab * const slab, cJSON_SlabStats * const stats)
+{
+    if (stats == NULL)
     {
-        return NULL;
+        return;
     }
 
-    v1_len = strlen(valuestring);
-    v2_len = strlen(object->valuestring);
+    stats->nodes_per_page = slab->nodes_per_page;
+    stats->pages = slab->page_count;
+    stats->nodes_in_use = slab->nodes_in_use;
+    stats->nodes_free = slab->node_count - slab->nodes_in_use;
+    stats->bytes = (slab->node_count * sizeof(cJSON)) + (slab->page_capacity * sizeof(cJSON_SlabPage));
+}
 
-    if (v1_len <= v2_len)
+CJSON_PUBLIC(cJSON_bool) cJSON_EnableNodeSlab(size_t nodes_per_page)
+{
+    return slab_enable(&global_hooks, &global_slab, nodes_per_page);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_DisableNodeSlab(void)
+{
+    return slab_disable(&global_hooks, &global_slab);
+}
+
+CJSON_PUBLIC(void) cJSON_GetNodeSlabStats(cJSON_SlabStats *stats)
+{
+    slab_stats(&global_slab, stats);
+}
+
+/* Internal constructor. */
+static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
+{
+    cJSON* node = NULL;
+    if (hooks->slab != NULL)
     {
-        /* strcpy does not handle overlapping string: [X1, X2] [Y1, Y2] => X2 < Y1 or Y2 < X1 */
-        if (!( valuestring + v1_len < object->valuestring || object->valuestring + v2_len < valuestring ))
-        {
-            return NULL;
-        }
-        strcpy(object->valuestring, valuestring);
-        return object->valuestring;
+        node = slab_allocate(hooks->slab, hooks);
     }
-    copy = (char*) cJSON_strdup((const unsigned char*)valuestring, &global_hooks);
-    if (copy == NULL)
+    else
     {
-        return NULL;
+        node = (cJSON*)hooks->allocate(hooks->user_data, sizeof(cJSON));
     }
-    if (object->valuestring != NULL)
+    if (node)
     {
-        cJSON_free(object->valuestring);
+        memset(node, '\0', sizeof(cJSON));
     }
-    object->valuestring = copy;
 
-    return copy;
+    return node;
 }
 
-typedef struct
+static void index_drop(cJSON * const item);
+
+/* Delete a cJSON structure that was allocated with the given hooks.
+ * Instead of recursing, the first child of an item is rotated in front of it (the child's next becomes the item,
+ * the item's child the rest of the children), so child and next are the work list and the depth doesn't matter.
+ * Slab nodes are collected and given back to the slab in one go. */
+static void delete_item(cJSON *item, const internal_hooks * const hooks)
 {
-    unsigned char *buffer;
-    size_t length;
-    size_t offset;
-    size_t depth; /* current nesting depth (for formatted printing) */
-    cJSON_bool noalloc;
-    cJSON_bool format; /* is this print a formatted print */
-    internal_hooks hooks;
-} printbuffer;
+    cJSON *next = NULL;
+    cJSON *slab_first = NULL;
+    cJSON *slab_last = NULL;
+    size_t slab_count = 0;
 
-/* realloc printbuffer if necessary to have at least "needed" bytes more */
-static unsigned char* ensure(printbuffer * const p, size_t needed)
+    while (item != NULL)
+    {
+        if (!(item->type & cJSON_IsReference) && (item->child != NULL))
+        {
+            next = item->child;
+            item->child = next->next;
+            next->next = item;
+            item = next;
+            continue;
+        }
+
+        next = item->next;
+        if (item->type & (cJSON_Array | cJSON_Object))
+        {
+            /* valuestring holds the lookup index */
+            index_drop(item);
+        }
+        else if (!(item->type & cJSON_IsReference) && (item->valuestring != NULL))
+        {
+            hooks->deallocate(hooks->user_data, item->valuestring);
+            item->valuestring = NULL;
+        }
+        if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
+        {
+            hooks->deallocate(hooks->user_data, item->string);
+            item->string = NULL;
+        }
+        if (item->type & cJSON_ArenaOwned)
+        {
+            /* freed with the arena */
+        }
+        else if (slab_owns(hooks->slab, item))
+        {
+            item->next = slab_first;
+            slab_first = item;
+            if (slab_last == NULL)
+            {
+                slab_last = item;
+            }
+            slab_count++;
+        }
+        else
+        {
+            hooks->deallocate(hooks->user_data, item);
+        }
+        item = next;
+    }
+
+    if (slab_first != NULL)
+    {
+        slab_free_chain(hooks->slab, slab_first, slab_last, slab_count);
+    }
+}
+
+/* Delete a cJSON structure. */
+CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
 {
-    unsigned char *newbuffer = NULL;
-    size_t newsize = 0;
+    delete_item(item, &global_hooks);
+}
 
-    if ((p == NULL) || (p->buffer == NULL))
+typedef struct cJSON_ArenaBlock
+{
+    struct cJSON_ArenaBlock *next;
+    size_t size; /* usable bytes after the header */
+    size_t used;
+} cJSON_ArenaBlock;
+
+#define CJSON_ARENA_DEFAULT_BLOCK_SIZE 4096
+#define CJSON_ARENA_MAX_BLOCK_SIZE (1024 * 1024)
+
+/* round up so that every allocation is suitably aligned for a cJSON node */
+#define arena_align(size) (((size) + (sizeof(double) - 1)) & ~(sizeof(double) - 1))
+#define arena_block_data(block) ((unsigned char*)(block) + arena_align(sizeof(cJSON_ArenaBlock)))
+
+CJSON_PUBLIC(void) cJSON_ArenaInit(cJSON_Arena *arena, size_t block_size)
+{
+    if (arena == NULL)
     {
-        return NULL;
+        return;
     }
 
-    if ((p->length > 0) && (p->offset >= p->length))
+    arena->blocks = NULL;
+    arena->current = NULL;
+    arena->block_size = block_size;
+}
+
+/* make the next block in the chain current, allocating one if there is none that has "size" bytes */
+static cJSON_ArenaBlock *arena_next_block(cJSON_Arena * const arena, size_t size)
+{
+    cJSON_ArenaBlock *current = arena->current;
+    cJSON_ArenaBlock *block = NULL;
+    size_t block_size = 0;
+
+    /* reuse blocks that were kept by cJSON_ArenaReset */
+    if ((current != NULL) && (current->next != NULL) && (current->next->size >= size))
+    {
+        block = current->next;
+        block->used = 0;
+        arena->current = block;
+
+        return block;
+    }
+
+    block_size = (arena->block_size != 0) ? arena->block_size : CJSON_ARENA_DEFAULT_BLOCK_SIZE;
+    if ((current != NULL) && (current->size < CJSON_ARENA_MAX_BLOCK_SIZE) && (block_size < current->size * 2))
+    {
+        block_size = current->size * 2;
+    }
+    if (block_size < size)
+    {
+        block_size = size;
+    }
+    if (block_size > ((size_t)-1 - arena_align(sizeof(cJSON_ArenaBlock))))
     {
-        /* make sure that offset is valid */
         return NULL;
     }
 
-    if (needed > INT_MAX)
+    block = (cJSON_ArenaBlock*)global_hooks.allocate(global_hooks.user_data, arena_align(sizeof(cJSON_ArenaBlock)) + block_size);
+    if (block == NULL)
     {
-        /* sizes bigger than INT_MAX are currently not supported */
         return NULL;
     }
+    block->size = block_size;
+    block->used = 0;
 
-    needed += p->offset + 1;
-    if (needed <= p->length)
+    /* insert after the current block, so that smaller blocks further down the chain are still reused */
+    if (current == NULL)
     {
-        return p->buffer + p->offset;
+        block->next = arena->blocks;
+        arena->blocks = block;
     }
+    else
+    {
+        block->next = current->next;
+        current->next = block;
+    }
+    arena->current = block;
 
-    if (p->noalloc) {
+    return block;
+}
+
+static void *arena_allocate(cJSON_Arena * const arena, size_t size)
+{
+    cJSON_ArenaBlock *block = arena->current;
+    unsigned char *pointer = NULL;
+
+    if (size > ((size_t)-1 - sizeof(double)))
+    {
         return NULL;
     }
+    size = arena_align(size);
 
-    /* calculate new buffer size */
-    if (needed > (INT_MAX / 2))
+    if ((block == NULL) || (size > (block->size - block->used)))
     {
-        /* overflow of int, use INT_MAX if possible */
-        if (needed <= INT_MAX)
-        {
-            newsize = INT_MAX;
-        }
-        else
+        block = arena_next_block(arena, size);
+        if (block == NULL)
         {
             return NULL;
         }
     }
-    else
+
+    pointer = arena_block_data(block) + block->used;
+    block->used += size;
+
+    return pointer;
+}
+
+CJSON_PUBLIC(void) cJSON_ArenaReset(cJSON_Arena *arena)
+{
+    if (arena == NULL)
     {
-        newsize = needed * 2;
+        return;
     }
 
-    if (p->hooks.reallocate != NULL)
+    /* the following blocks are cleared lazily once allocation reaches them */
+    arena->current = arena->blocks;
+    if (arena->current != NULL)
     {
-        /* reallocate with realloc if available */
-        newbuffer = (unsigned char*)p->hooks.reallocate(p->buffer, newsize);
-        if (newbuffer == NULL)
-        {
-            p->hooks.deallocate(p->buffer);
-            p->length = 0;
-            p->buffer = NULL;
+        arena->current->used = 0;
+    }
+}
 
-            return NULL;
-        }
+CJSON_PUBLIC(void) cJSON_ArenaFree(cJSON_Arena *arena)
+{
+    cJSON_ArenaBlock *block = NULL;
+    cJSON_ArenaBlock *next = NULL;
+
+    if (arena == NULL)
+    {
+        return;
     }
-    else
+
+    for (block = arena->blocks; block != NULL; block = next)
     {
-        /* otherwise reallocate manually */
-        newbuffer = (unsigned char*)p->hooks.allocate(newsize);
-        if (!newbuffer)
-        {
-            p->hooks.deallocate(p->buffer);
-            p->length = 0;
-            p->buffer = NULL;
+        next = block->next;
+        global_hooks.deallocate(global_hooks.user_data, block);
+    }
 
-            return NULL;
-        }
+    arena->blocks = NULL;
+    arena->current = NULL;
+}
 
-        memcpy(newbuffer, p->buffer, p->offset + 1);
-        p->hooks.deallocate(p->buffer);
+/* get the decimal point character of the current locale */
+static unsigned char get_decimal_point(void)
+{
+#ifdef ENABLE_LOCALES
+    struct lconv *lconv = localeconv();
+    return (unsigned char) lconv->decimal_point[0];
+#else
+    return '.';
+#endif
+}
+
+typedef struct
+{
+    const unsigned char *content;
+    size_t length;
+    size_t offset;
+    size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
+    internal_hooks hooks;
+    cJSON_Arena *arena; /* if not NULL, the tree is allocated from here instead of through the hooks */
+    unsigned char *in_place; /* writable alias of content if strings may be terminated in place */
+    int error; /* cJSON_ParseError... of the first failure */
+} parse_buffer;
+
+/* remember why parsing failed, the innermost failure is the most precise one so it wins */
+static void parse_fail(parse_buffer * const buffer, const int reason)
+{
+    if (buffer->error == cJSON_ParseErrorNone)
+    {
+        buffer->error = reason;
     }
-    p->length = newsize;
-    p->buffer = newbuffer;
+}
 
-    return newbuffer + p->offset;
+/* something else was expected at the current offset */
+static void parse_fail_unexpected(parse_buffer * const buffer)
+{
+    parse_fail(buffer, (buffer->offset < buffer->length) ? cJSON_ParseErrorUnexpectedCharacter : cJSON_ParseErrorUnexpectedEnd);
 }
 
-/* calculate the new length of the string in a printbuffer and update the offset */
-static void update_offset(printbuffer * const buffer)
+/* allocate memory for the tree that is being parsed */
+static void *parse_allocate(const parse_buffer * const buffer, size_t size)
 {
-    const unsigned char *buffer_pointer = NULL;
-    if ((buffer == NULL) || (buffer->buffer == NULL))
+    if (buffer->arena != NULL)
     {
-        return;
+        return arena_allocate(buffer->arena, size);
     }
-    buffer_pointer = buffer->buffer + buffer->offset;
 
-    buffer->offset += strlen((const char*)buffer_pointer);
+    return buffer->hooks.allocate(buffer->hooks.user_data, size);
 }
 
-/* securely comparison of floating-point variables */
-static cJSON_bool compare_double(double a, double b)
+static void parse_deallocate(const parse_buffer * const buffer, void *pointer)
 {
-    double maxVal = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
-    return (fabs(a - b) <= maxVal * DBL_EPSILON);
+    /* arena memory is given back all at once when a failed parse is rolled back */
+    if (buffer->arena == NULL)
+    {
+        buffer->hooks.deallocate(buffer->hooks.user_data, pointer);
+    }
 }
 
-/* Render the number nicely from the given item into a string. */
-static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+static cJSON *parse_new_item(const parse_buffer * const buffer)
 {
-    unsigned char *output_pointer = NULL;
-    double d = item->valuedouble;
-    int length = 0;
-    size_t i = 0;
-    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
-    unsigned char decimal_point = get_decimal_point();
-    double test = 0.0;
+    cJSON *node = NULL;
 
-    if (output_buffer == NULL)
+    if (buffer->arena == NULL)
     {
-        return false;
+        return cJSON_New_Item(&buffer->hooks);
     }
 
-    /* This checks for NaN and Infinity */
-    if (isnan(d) || isinf(d))
+    node = (cJSON*)arena_allocate(buffer->arena, sizeof(cJSON));
+    if (node != NULL)
     {
-        length = sprintf((char*)number_buffer, "null");
+        memset(node, '\0', sizeof(cJSON));
     }
-    else if(d == (double)item->valueint)
+
+    return node;
+}
+
+static void parse_delete(const parse_buffer * const buffer, cJSON *item)
+{
+    if (buffer->arena == NULL)
     {
-        length = sprintf((char*)number_buffer, "%d", item->valueint);
+        delete_item(item, &buffer->hooks);
     }
-    else
-    {
-        /* Try 15 decimal places of precision to avoid nonsignificant nonzero digits */
-        length = sprintf((char*)number_buffer, "%1.15g", d);
+}
 
-        /* Check whether the original double can be recovered */
-        if ((sscanf((char*)number_buffer, "%lg", &test) != 1) || !compare_double((double)test, d))
-        {
-            /* If not, print with 17 decimal places of precision */
-            length = sprintf((char*)number_buffer, "%1.17g", d);
-        }
+/* flag the memory of a freshly parsed arena item, so that cJSON_Delete and friends don't free it */
+static void parse_mark_item(const parse_buffer * const buffer, cJSON * const item)
+{
+    if (buffer->arena == NULL)
+    {
+        return;
     }
 
-    /* sprintf failed or buffer overrun occurred */
-    if ((length < 0) || (length > (int)(sizeof(number_buffer) - 1)))
+    item->type |= cJSON_ArenaOwned;
+    if ((item->type & 0xFF) == cJSON_String)
     {
-        return false;
+        item->type |= cJSON_IsReference;
     }
-
-    /* reserve appropriate space in the output */
-    output_pointer = ensure(output_buffer, (size_t)length + sizeof(""));
-    if (output_pointer == NULL)
+    if (item->string != NULL)
     {
-        return false;
+        item->type |= cJSON_StringIsConst;
     }
+}
+
+/* check if the given size is left to read in a given parse buffer (starting with 1) */
+#define can_read(buffer, size) ((buffer != NULL) && (((buffer)->offset + size) <= (buffer)->length))
+/* check if the buffer can be accessed at the given index (starting with 0) */
+#define can_access_at_index(buffer, index) ((buffer != NULL) && (((buffer)->offset + index) < (buffer)->length))
+#define cannot_access_at_index(buffer, index) (!can_access_at_index(buffer, index))
+/* get a pointer to the buffer at the position */
+#define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
+
+/* Scanning primitives used by the parser. Each returns the offset of the first byte that stops the scan,
+ * or length if there is none. The vector versions look at 16 or 32 bytes per step and finish with the scalar loop. */
+#if defined(CJSON_SIMD_SSE2)
+static unsigned int trailing_zeros(unsigned int mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return (unsigned int)index;
+#else
+    return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+#if defined(CJSON_SIMD_AVX2)
+#if defined(__GNUC__) || defined(__clang__)
+#define CJSON_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CJSON_TARGET_AVX2
+#endif
+
+static int avx2_support = -1;
 
-    /* copy the printed number to the output and replace locale
-     * dependent decimal point with '.' */
-    for (i = 0; i < ((size_t)length); i++)
+static cJSON_bool cpu_has_avx2(void)
+{
+    if (avx2_support < 0)
     {
-        if (number_buffer[i] == decimal_point)
+#if defined(_MSC_VER)
+        int registers[4] = { 0, 0, 0, 0 };
+        int supported = 0;
+        __cpuid(registers, 0);
+        if (registers[0] >= 7)
         {
-            output_pointer[i] = '.';
-            continue;
+            __cpuid(registers, 1);
+            /* OSXSAVE and AVX, and the OS saves the YMM registers */
+            if (((registers[2] & (1 << 27)) != 0) && ((registers[2] & (1 << 28)) != 0) && ((_xgetbv(0) & 6) == 6))
+            {
+                __cpuidex(registers, 7, 0);
+                supported = (registers[1] & (1 << 5)) != 0;
+            }
         }
-
-        output_pointer[i] = number_buffer[i];
+        avx2_support = supported;
+#else
+        avx2_support = __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
     }
-    output_pointer[i] = '\0';
 
-    output_buffer->offset += (size_t)length;
-
-    return true;
+    return avx2_support != 0;
 }
 
-/* parse 4 digit hexadecimal number */
-static unsigned parse_hex4(const unsigned char * const input)
+/* advances *position over whole 32 byte blocks, returns true if the stopping byte was found */
+CJSON_TARGET_AVX2 static cJSON_bool scan_whitespace_avx2(const unsigned char * const input, size_t length, size_t * const position)
 {
-    unsigned int h = 0;
-    size_t i = 0;
+    size_t i = *position;
+    const __m256i space = _mm256_set1_epi8(' ');
 
-    for (i = 0; i < 4; i++)
+    for (; (i + 32) <= length; i += 32)
     {
-        /* parse digit */
-        if ((input[i] >= '0') && (input[i] <= '9'))
-        {
-            h += (unsigned int) input[i] - '0';
-        }
-        else if ((input[i] >= 'A') && (input[i] <= 'F'))
-        {
-            h += (unsigned int) 10 + input[i] - 'A';
-        }
-        else if ((input[i] >= 'a') && (input[i] <= 'f'))
-        {
-            h += (unsigned int) 10 + input[i] - 'a';
-        }
-        else /* invalid */
+        const __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)(input + i));
+        /* byte <= ' ' exactly when min(byte, ' ') == byte */
+        const unsigned int whitespace = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(chunk, space), chunk));
+        if (whitespace != 0xFFFFFFFFu)
         {
-            return 0;
+            *position = i + trailing_zeros(~whitespace);
+            return true;
         }
+    }
+
+    *position = i;
+    return false;
+}
+
+CJSON_TARGET_AVX2 static cJSON_bool scan_string_special_avx2(const unsigned char * const input, size_t length, size_t * const position)
+{
+    size_t i = *position;
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
 
-        if (i < 3)
+    for (; (i + 32) <= length; i += 32)
+    {
+        const __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)(input + i));
+        const unsigned int special = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)));
+        if (special != 0)
         {
-            /* shift left to make place for the next nibble */
-            h = h << 4;
+            *position = i + trailing_zeros(special);
+            return true;
         }
     }
 
-    return h;
+    *position = i;
+    return false;
 }
 
-/* converts a UTF-16 literal to UTF-8
- * A literal can be one or two sequences of the form \uXXXX */
-static unsigned char utf16_literal_to_utf8(const unsigned char * const input_pointer, const unsigned char * const input_end, unsigned char **output_pointer)
+CJSON_TARGET_AVX2 static cJSON_bool scan_escape_special_avx2(const unsigned char * const input, size_t length, size_t * const position)
 {
-    long unsigned int codepoint = 0;
-    unsigned int first_code = 0;
-    const unsigned char *first_sequence = input_pointer;
-    unsigned char utf8_length = 0;
-    unsigned char utf8_position = 0;
-    unsigned char sequence_length = 0;
-    unsigned char first_byte_mark = 0;
+    size_t i = *position;
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(31);
 
-    if ((input_end - first_sequence) < 6)
+    for (; (i + 32) <= length; i += 32)
     {
-        /* input ends unexpectedly */
-        goto fail;
+        const __m256i chunk = _mm256_loadu_si256((const __m256i*)(const void*)(input + i));
+        const __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control), chunk), _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)));
+        const unsigned int mask = (unsigned int)_mm256_movemask_epi8(special);
+        if (mask != 0)
+        {
+            *position = i + trailing_zeros(mask);
+            return true;
+        }
     }
 
-    /* get the first utf16 sequence */
-    first_code = parse_hex4(first_sequence + 2);
+    *position = i;
+    return false;
+}
+#endif /* CJSON_SIMD_AVX2 */
+#endif /* CJSON_SIMD_SSE2 */
 
-    /* check that the code is valid */
-    if (((first_code >= 0xDC00) && (first_code <= 0xDFFF)))
+/* skip bytes <= 32, which is everything cJSON treats as whitespace */
+static size_t scan_whitespace(const unsigned char * const input, size_t length)
+{
+    size_t i = 0;
+
+#if defined(CJSON_SIMD_SSE2)
+#if defined(CJSON_SIMD_AVX2)
+    if ((length >= 32) && cpu_has_avx2() && scan_whitespace_avx2(input, length, &i))
     {
-        goto fail;
+        return i;
     }
-
-    /* UTF16 surrogate pair */
-    if ((first_code >= 0xD800) && (first_code <= 0xDBFF))
+#endif
     {
-        const unsigned char *second_sequence = first_sequence + 6;
-        unsigned int second_code = 0;
-        sequence_length = 12; /* \uXXXX\uXXXX */
-
-        if ((input_end - second_sequence) < 6)
-        {
-            /* input ends unexpectedly */
-            goto fail;
-        }
-
-        if ((second_sequence[0] != '\\') || (second_sequence[1] != 'u'))
-        {
-            /* missing second half of the surrogate pair */
-            goto fail;
-        }
-
-        /* get the second utf16 sequence */
-        second_code = parse_hex4(second_sequence + 2);
-        /* check that the code is valid */
-        if ((second_code < 0xDC00) || (second_code > 0xDFFF))
+        const __m128i space = _mm_set1_epi8(' ');
+        for (; (i + 16) <= length; i += 16)
         {
-            /* invalid second half of the surrogate pair */
-            goto fail;
+            const __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(input + i));
+            const unsigned int whitespace = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(chunk, space), chunk));
+            if (whitespace != 0xFFFFu)
+            {
+                return i + trailing_zeros(~whitespace);
+            }
         }
-
-
-        /* calculate the unicode codepoint from the surrogate pair */
-        codepoint = 0x10000 + (((first_code & 0x3FF) << 10) | (second_code & 0x3FF));
-    }
-    else
-    {
-        sequence_length = 6; /* \uXXXX */
-        codepoint = first_code;
     }
+#endif
 
-    /* encode as UTF-8
-     * takes at maximum 4 bytes to encode:
-     * 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
-    if (codepoint < 0x80)
+    while ((i < length) && (input[i] <= 32))
     {
-        /* normal ascii, encoding 0xxxxxxx */
-        utf8_length = 1;
-    }
-    else if (codepoint < 0x800)
-    {
-        /* two bytes, encoding 110xxxxx 10xxxxxx */
-        utf8_length = 2;
-        first_byte_mark = 0xC0; /* 11000000 */
-    }
-    else if (codepoint < 0x10000)
-    {
-        /* three bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx */
-        utf8_length = 3;
-        first_byte_mark = 0xE0; /* 11100000 */
+        i++;
     }
-    else if (codepoint <= 0x10FFFF)
+
+    return i;
+}
+
+/* find the next '\"' or '\\' */
+static size_t scan_string_special(const unsigned char * const input, size_t length)
+{
+    size_t i = 0;
+
+#if defined(CJSON_SIMD_SSE2)
+#if defined(CJSON_SIMD_AVX2)
+    if ((length >= 32) && cpu_has_avx2() && scan_string_special_avx2(input, length, &i))
     {
-        /* four bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx 10xxxxxx */
-        utf8_length = 4;
-        first_byte_mark = 0xF0; /* 11110000 */
+        return i;
     }
-    else
+#endif
     {
-        /* invalid unicode codepoint */
-        goto fail;
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        for (; (i + 16) <= length; i += 16)
+        {
+            const __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(input + i));
+            const unsigned int special = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+            if (special != 0)
+            {
+                return i + trailing_zeros(special);
+            }
+        }
     }
+#endif
 
-    /* encode as utf8 */
-    for (utf8_position = (unsigned char)(utf8_length - 1); utf8_position > 0; utf8_position--)
+    while ((i < length) && (input[i] != '\"') && (input[i] != '\\'))
     {
-        /* 10xxxxxx */
-        (*output_pointer)[utf8_position] = (unsigned char)((codepoint | 0x80) & 0xBF);
-        codepoint >>= 6;
+        i++;
     }
-    /* encode first byte */
-    if (utf8_length > 1)
+
+    return i;
+}
+
+/* find the next '\"' or '\n' */
+static size_t scan_line_special(const unsigned char * const input, size_t length)
+{
+    size_t i = 0;
+
+#if defined(CJSON_SIMD_SSE2)
     {
-        (*output_pointer)[0] = (unsigned char)((codepoint | first_byte_mark) & 0xFF);
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i newline = _mm_set1_epi8('\n');
+        for (; (i + 16) <= length; i += 16)
+        {
+            const __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(input + i));
+            const unsigned int special = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, newline)));
+            if (special != 0)
+            {
+                return i + trailing_zeros(special);
+            }
+        }
     }
-    else
+#endif
+
+    while ((i < length) && (input[i] != '\"') && (input[i] != '\n'))
     {
-        (*output_pointer)[0] = (unsigned char)(codepoint & 0x7F);
+        i++;
     }
 
-    *output_pointer += utf8_length;
-
-    return sequence_length;
-
-fail:
-    return 0;
+    return i;
 }
 
-/* Parse the input text into an unescaped cinput, and populate item. */
-static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer)
+/* find the next byte that has to be escaped when printing a string: '\"', '\\' or a control character */
+static size_t scan_escape_special(const unsigned char * const input, size_t length)
 {
-    const unsigned char *input_pointer = buffer_at_offset(input_buffer) + 1;
-    const unsigned char *input_end = buffer_at_offset(input_buffer) + 1;
-    unsigned char *output_pointer = NULL;
-    unsigned char *output = NULL;
+    size_t i = 0;
 
-    /* not a string */
-    if (buffer_at_offset(input_buffer)[0] != '\"')
+#if defined(CJSON_SIMD_SSE2)
+#if defined(CJSON_SIMD_AVX2)
+    if ((length >= 32) && cpu_has_avx2() && scan_escape_special_avx2(input, length, &i))
     {
-        goto fail;
+        return i;
     }
-
+#endif
     {
-        /* calculate approximate size of the output (overestimate) */
-        size_t allocation_length = 0;
-        size_t skipped_bytes = 0;
-        while (((size_t)(input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"'))
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i control = _mm_set1_epi8(31);
+        for (; (i + 16) <= length; i += 16)
         {
-            /* is escape sequence */
-            if (input_end[0] == '\\')
+            const __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(input + i));
+            const __m128i special = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk), _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+            const unsigned int mask = (unsigned int)_mm_movemask_epi8(special);
+            if (mask != 0)
             {
-                if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
-                {
-                    /* prevent buffer overflow when last input character is a backslash */
-                    goto fail;
-                }
-                skipped_bytes++;
-                input_end++;
+                return i + trailing_zeros(mask);
             }
-            input_end++;
-        }
-        if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"'))
-        {
-            goto fail; /* string ended unexpectedly */
-        }
-
-        /* This is at most how much we need for the output */
-        allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
-        if (output == NULL)
-        {
-            goto fail; /* allocation failure */
         }
     }
+#endif
 
-    output_pointer = output;
-    /* loop through the string literal */
-    while (input_pointer < input_end)
+    while ((i < length) && (input[i] > 31) && (input[i] != '\"') && (input[i] != '\\'))
     {
-        if (*input_pointer != '\\')
-        {
-            *output_pointer++ = *input_pointer++;
-        }
-        /* escape sequence */
-        else
-        {
-            unsigned char sequence_length = 2;
-            if ((input_end - input_pointer) < 1)
-            {
-                goto fail;
-            }
-
-            switch (input_pointer[1])
-            {
-                case 'b':
-                    *output_pointer++ = '\b';
-                    break;
-                case 'f':
-                    *output_pointer++ = '\f';
-                    break;
-                case 'n':
-                    *output_pointer++ = '\n';
-                    break;
-                case 'r':
-                    *output_pointer++ = '\r';
-                    break;
-                case 't':
-                    *output_pointer++ = '\t';
-                    break;
-                case '\"':
-                case '\\':
-                case '/':
-                    *output_pointer++ = input_pointer[1];
-                    break;
-
-                /* UTF-16 literal */
-                case 'u':
-                    sequence_length = utf16_literal_to_utf8(input_pointer, input_end, &output_pointer);
-                    if (sequence_length == 0)
-                    {
-                        /* failed to convert UTF16-literal to UTF-8 */
-                        goto fail;
-                    }
-                    break;
-
-                default:
-                    goto fail;
-            }
-            input_pointer += sequence_length;
-        }
+        i++;
     }
 
-    /* zero terminate the output */
-    *output_pointer = '\0';
+    return i;
+}
 
-    item->type = cJSON_String;
-    item->valuestring = (char*)output;
+/* Clinger's fast path relies on every multiplication and division being rounded straight to double
+ * precision, which isn't the case with x87 extended precision arithmetic. <float.h> only defines
+ * FLT_EVAL_METHOD since C99, so also ask the compiler, and leave the fast path out if nobody can tell.
+ * 64 bit MSVC targets always do double arithmetic in SSE2 or NEON registers. */
+#if defined(FLT_EVAL_METHOD)
+#if FLT_EVAL_METHOD == 0
+#define CJSON_EXACT_DOUBLE_ARITHMETIC
+#endif
+#elif defined(__FLT_EVAL_METHOD__)
+#if __FLT_EVAL_METHOD__ == 0
+#define CJSON_EXACT_DOUBLE_ARITHMETIC
+#endif
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#define CJSON_EXACT_DOUBLE_ARITHMETIC
+#endif
 
-    input_buffer->offset = (size_t) (input_end - input_buffer->content);
-    input_buffer->offset++;
+/* longest number that parse_number hands to strtod, longer ones are cut off there */
+#define CJSON_NUMBER_MAX_LENGTH 63
 
-    return true;
+/* Convert a number directly from the input when the result is guaranteed to be the correctly rounded
+ * value that strtod returns: a decimal mantissa of at most 2^53 and a power of ten that is exact as a double.
+ * Returns false for everything else (long mantissas, large exponents, "1.", "-.5", ...), those go through strtod. */
+static cJSON_bool parse_number_fast(const unsigned char * const input, size_t length, double * const number, size_t * const number_length)
+{
+    static const double exact_powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const cjson_uint64 max_exact_mantissa = CJSON_UINT64_C(9007199254740992); /* 2^53 */
+    cjson_uint64 mantissa = 0;
+    size_t digits = 0;
+    long exponent = 0;
+    cJSON_bool negative = false;
+    size_t i = 0;
+    double value = 0;
 
-fail:
-    if (output != NULL)
+    if (length > CJSON_NUMBER_MAX_LENGTH)
     {
-        input_buffer->hooks.deallocate(output);
-        output = NULL;
+        length = CJSON_NUMBER_MAX_LENGTH;
     }
 
-    if (input_pointer != NULL)
+    if ((i < length) && (input[i] == '-'))
     {
-        input_buffer->offset = (size_t)(input_pointer - input_buffer->content);
+        negative = true;
+        i++;
     }
-
-    return false;
-}
-
-/* Render the cstring provided to an escaped version that can be printed. */
-static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
-{
-    const unsigned char *input_pointer = NULL;
-    unsigned char *output = NULL;
-    unsigned char *output_pointer = NULL;
-    size_t output_length = 0;
-    /* numbers of additional characters needed for escaping */
-    size_t escape_characters = 0;
-
-    if (output_buffer == NULL)
+    if ((i >= length) || (input[i] < '0') || (input[i] > '9'))
     {
         return false;
     }
 
-    /* empty string */
-    if (input == NULL)
+    /* integer part */
+    for (; (i < length) && (input[i] >= '0') && (input[i] <= '9'); i++, digits++)
     {
-        output = ensure(output_buffer, sizeof("\"\""));
-        if (output == NULL)
+        mantissa = (mantissa * 10) + (cjson_uint64)(input[i] - '0');
+    }
+
+    /* fraction */
+    if ((i < length) && (input[i] == '.'))
+    {
+        i++;
+        if ((i >= length) || (input[i] < '0') || (input[i] > '9'))
         {
             return false;
         }
-        strcpy((char*)output, "\"\"");
+        for (; (i < length) && (input[i] >= '0') && (input[i] <= '9'); i++, digits++)
+        {
+            mantissa = (mantissa * 10) + (cjson_uint64)(input[i] - '0');
+            exponent--;
+        }
+    }
 
-        return true;
+    /* 19 decimal digits always fit into 64 bits */
+    if (digits > 19)
+    {
+        return false;
     }
 
-    /* set "flag" to 1 if something needs to be escaped */
-    for (input_pointer = input; *input_pointer; input_pointer++)
+    /* exponent, strtod doesn't consume an 'e' that isn't followed by digits */
+    if ((i < length) && ((input[i] == 'e') || (input[i] == 'E')))
     {
-        switch (*input_pointer)
+        size_t exponent_start = i + 1;
+        cJSON_bool exponent_negative = false;
+        long exponent_value = 0;
+
+        if ((exponent_start < length) && ((input[exponent_start] == '+') || (input[exponent_start] == '-')))
         {
-            case '\"':
-            case '\\':
-            case '\b':
-            case '\f':
-            case '\n':
-            case '\r':
-            case '\t':
-                /* one character escape sequence */
-                escape_characters++;
-                break;
-            default:
-                if (*input_pointer < 32)
+            exponent_negative = (input[exponent_start] == '-');
+            exponent_start++;
+        }
+        if ((exponent_start < length) && (input[exponent_start] >= '0') && (input[exponent_start] <= '9'))
+        {
+            for (i = exponent_start; (i < length) && (input[i] >= '0') && (input[i] <= '9'); i++)
+            {
+                if (exponent_value < 100000)
                 {
-                    /* UTF-16 escape sequence uXXXX */
-                    escape_characters += 5;
+                    exponent_value = (exponent_value * 10) + (long)(input[i] - '0');
                 }
-                break;
+            }
+            exponent += exponent_negative ? -exponent_value : exponent_value;
         }
     }
-    output_length = (size_t)(input_pointer - input) + escape_characters;
 
-    output = ensure(output_buffer, output_length + sizeof("\"\""));
-    if (output == NULL)
+    /* a number that continues past the length limit is cut off by the strtod path, keep that behaviour */
+    if ((i == length) && (length == CJSON_NUMBER_MAX_LENGTH))
     {
         return false;
     }
 
-    /* no characters have to be escaped */
-    if (escape_characters == 0)
+    if (mantissa > max_exact_mantissa)
     {
-        output[0] = '\"';
-        memcpy(output + 1, input, output_length);
-        output[output_length + 1] = '\"';
-        output[output_length + 2] = '\0';
-
-        return true;
+        return false;
     }
 
-    output[0] = '\"';
-    output_pointer = output + 1;
-    /* copy the string */
-    for (input_pointer = input; *input_pointer != '\0'; (void)input_pointer++, output_pointer++)
+    if ((mantissa == 0) || (exponent == 0))
     {
-        if ((*input_pointer > 31) && (*input_pointer != '\"') && (*input_pointer != '\\'))
-        {
-            /* normal character, copy */
-            *output_pointer = *input_pointer;
-        }
-        else
+        value = (double)mantissa;
+    }
+#ifdef CJSON_EXACT_DOUBLE_ARITHMETIC
+    else if ((exponent > 0) && (exponent <= 22))
+    {
+        value = (double)mantissa * exact_powers_of_ten[exponent];
+    }
+    else if ((exponent < 0) && (exponent >= -22))
+    {
+        value = (double)mantissa / exact_powers_of_ten[-exponent];
+    }
+    else if ((exponent > 22) && (exponent <= (22 + 15)))
+    {
+        /* move the excess into the mantissa if it stays exact, e.g. 1e30 */
+        long excess = exponent - 22;
+        for (; excess > 0; excess--)
         {
-            /* character needs to be escaped */
-            *output_pointer++ = '\\';
-            switch (*input_pointer)
+            mantissa *= 10;
+            if (mantissa > max_exact_mantissa)
             {
-                case '\\':
-                    *output_pointer = '\\';
-                    break;
-                case '\"':
-                    *output_pointer = '\"';
-                    break;
-                case '\b':
-                    *output_pointer = 'b';
-                    break;
-                case '\f':
-                    *output_pointer = 'f';
-                    break;
-                case '\n':
-                    *output_pointer = 'n';
-                    break;
-                case '\r':
-                    *output_pointer = 'r';
-                    break;
-                case '\t':
-                    *output_pointer = 't';
-                    break;
-                default:
-                    /* escape and print as unicode codepoint */
-                    sprintf((char*)output_pointer, "u%04x", *input_pointer);
-                    output_pointer += 4;
-                    break;
+                return false;
             }
         }
+        value = (double)mantissa * exact_powers_of_ten[22];
+    }
+#endif
+    else
+    {
+        return false;
     }
-    output[output_length + 1] = '\"';
-    output[output_length + 2] = '\0';
+
+    *number = negative ? -value : value;
+    *number_length = i;
 
     return true;
 }
 
-/* Invoke print_string_ptr (which is useful) on an item. */
-static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
+/* Parse the input text to generate a number, and populate the result into item. */
+static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
 {
-    return print_string_ptr((unsigned char*)item->valuestring, p);
-}
+    double number = 0;
+    size_t number_length = 0;
+    unsigned char *after_end = NULL;
+    unsigned char number_c_string[CJSON_NUMBER_MAX_LENGTH + 1];
+    unsigned char decimal_point = 0;
+    size_t i = 0;
 
-/* Predeclare these prototypes. */
-static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
-static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
-static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    {
+        return false;
+    }
 
-/* Utility to jump whitespace and cr/lf */
-static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
-{
-    if ((buffer == NULL) || (buffer->content == NULL))
+    if (parse_number_fast(buffer_at_offset(input_buffer), input_buffer->length - input_buffer->offset, &number, &number_length))
     {
-        return NULL;
+        goto parsed;
     }
 
-    if (cannot_access_at_index(buffer, 0))
+    decimal_point = get_decimal_point();
+
+    /* copy the number into a temporary buffer and replace '.' with the decimal point
+     * of the current locale (for strtod)
+     * This also takes care of '\0' not necessarily being available for marking the end of the input */
+    for (i = 0; (i < (sizeof(number_c_string) - 1)) && can_access_at_index(input_buffer, i); i++)
     {
-        return buffer;
+        switch (buffer_at_offset(input_buffer)[i])
+        {
+            case '0':
+            case '1':
+            case '2':
+            case '3':
+            case '4':
+            case '5':
+            case '6':
+            case '7':
+            case '8':
+            case '9':
+            case '+':
+            case '-':
+            case 'e':
+            case 'E':
+                number_c_string[i] = buffer_at_offset(input_buffer)[i];
+                break;
+
+            case '.':
+                number_c_string[i] = decimal_point;
+                break;
+
+            default:
+                goto loop_end;
+        }
     }
+loop_end:
+    number_c_string[i] = '\0';
 
-    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
+    number = strtod((const char*)number_c_string, (char**)&after_end);
+    if (number_c_string == after_end)
     {
-       buffer->offset++;
+        parse_fail(input_buffer, cJSON_ParseErrorInvalidNumber);
+        return false; /* parse_error */
     }
+    number_length = (size_t)(after_end - number_c_string);
 
-    if (buffer->offset == buffer->length)
+parsed:
+    item->valuedouble = number;
+
+    /* use saturation in case of overflow */
+    if (number >= INT_MAX)
     {
-        buffer->offset--;
+        item->valueint = INT_MAX;
+    }
+    else if (number <= (double)INT_MIN)
+    {
+        item->valueint = INT_MIN;
+    }
+    else
+    {
+        item->valueint = (int)number;
     }
 
-    return buffer;
+    item->type = cJSON_Number;
+
+    input_buffer->offset += number_length;
+    return true;
 }
 
-/* skip the UTF-8 BOM (byte order mark) if it is at the beginning of a buffer */
-static parse_buffer *skip_utf8_bom(parse_buffer * const buffer)
+/* don't ask me, but the original cJSON_SetNumberValue returns an integer or double */
+CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
 {
-    if ((buffer == NULL) || (buffer->content == NULL) || (buffer->offset != 0))
+    trees_changed();
+
+    if (number >= INT_MAX)
     {
-        return NULL;
+        object->valueint = INT_MAX;
     }
-
-    if (can_access_at_index(buffer, 4) && (strncmp((const char*)buffer_at_offset(buffer), "\xEF\xBB\xBF", 3) == 0))
+    else if (number <= (double)INT_MIN)
     {
-        buffer->offset += 3;
+        object->valueint = INT_MIN;
+    }
+    else
+    {
+        object->valueint = (int)number;
     }
 
-    return buffer;
+    return object->valuedouble = number;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+/* Note: when passing a NULL valuestring, cJSON_SetValuestring treats this as an error and return NULL */
+CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
 {
-    size_t buffer_length;
-
-    if (NULL == value)
+    char *copy = NULL;
+    size_t v1_len;
+    size_t v2_len;
+    /* if object's type is not cJSON_String or is cJSON_IsReference, it should not set valuestring */
+    if ((object == NULL) || !(object->type & cJSON_String) || (object->type & cJSON_IsReference))
+    {
+        return NULL;
+    }
+    /* return NULL if the object is corrupted or valuestring is NULL */
+    if (object->valuestring == NULL || valuestring == NULL)
     {
         return NULL;
     }
 
-    /* Adding null character size due to require_null_terminated. */
-    buffer_length = strlen(value) + sizeof("");
+    trees_changed();
 
-    return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
+    v1_len = strlen(valuestring);
+    v2_len = strlen(object->valuestring);
+
+    if (v1_len <= v2_len)
+    {
+        /* strcpy does not handle overlapping string: [X1, X2] [Y1, Y2] => X2 < Y1 or Y2 < X1 */
+        if (!( valuestring + v1_len < object->valuestring || object->valuestring + v2_len < valuestring ))
+        {
+            return NULL;
+        }
+        strcpy(object->valuestring, valuestring);
+        return object->valuestring;
+    }
+    copy = (char*) cJSON_strdup((const unsigned char*)valuestring, &global_hooks);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    if (object->valuestring != NULL)
+    {
+        cJSON_free(object->valuestring);
+    }
+    object->valuestring = copy;
+
+    return copy;
 }
 
-/* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+typedef struct
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
-    cJSON *item = NULL;
+    unsigned char *buffer;
+    size_t length;
+    size_t offset;
+    size_t depth; /* current nesting depth (for formatted printing) */
+    cJSON_bool noalloc;
+    cJSON_bool format; /* is this print a formatted print */
+    internal_hooks hooks;
+    /* if not NULL, the printed text is handed to this whenever the buffer is full (see cJSON_PrintToSink) */
+    cJSON_bool (*sink)(void *context, const char *data, size_t length);
+    void *sink_context;
+} printbuffer;
 
-    /* reset error position */
-    global_error.json = NULL;
-    global_error.position = 0;
+/* realloc printbuffer if necessary to have at least "needed" bytes more */
+static unsigned char* ensure(printbuffer * const p, size_t needed)
+{
+    unsigned char *newbuffer = NULL;
+    size_t newsize = 0;
 
-    if (value == NULL || 0 == buffer_length)
+    if ((p == NULL) || (p->buffer == NULL))
     {
-        goto fail;
+        return NULL;
     }
 
-    buffer.content = (const unsigned char*)value;
-    buffer.length = buffer_length;
-    buffer.offset = 0;
-    buffer.hooks = global_hooks;
+    if ((p->length > 0) && (p->offset > p->length))
+    {
+        /* make sure that offset is valid */
+        return NULL;
+    }
 
-    item = cJSON_New_Item(&global_hooks);
-    if (item == NULL) /* memory fail */
+    if (needed > INT_MAX)
     {
-        goto fail;
+        /* sizes bigger than INT_MAX are currently not supported */
+        return NULL;
     }
 
-    if (!parse_value(item, buffer_skip_whitespace(skip_utf8_bom(&buffer))))
+    /* the callers include the terminating zero in what they need */
+    needed += p->offset;
+    if (needed <= p->length)
     {
-        /* parse failure. ep is set. */
-        goto fail;
+        return p->buffer + p->offset;
     }
 
-    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
-    if (require_null_terminated)
+    if ((p->sink != NULL) && (p->offset > 0))
     {
-        buffer_skip_whitespace(&buffer);
-        if ((buffer.offset >= buffer.length) || buffer_at_offset(&buffer)[0] != '\0')
+        /* nothing before offset is looked at again, so flush it and start over at the beginning */
+        if (!p->sink(p->sink_context, (const char*)p->buffer, p->offset))
         {
-            goto fail;
+            return NULL;
+        }
+        needed -= p->offset;
+        p->offset = 0;
+        if (needed <= p->length)
+        {
+            return p->buffer;
         }
     }
-    if (return_parse_end)
-    {
-        *return_parse_end = (const char*)buffer_at_offset(&buffer);
-    }
-
-    return item;
 
-fail:
-    if (item != NULL)
-    {
-        cJSON_Delete(item);
+    if (p->noalloc) {
+        return NULL;
     }
 
-    if (value != NULL)
+    /* calculate new buffer size */
+    if (needed > (INT_MAX / 2))
     {
-        error local_error;
-        local_error.json = (const unsigned char*)value;
-        local_error.position = 0;
-
-        if (buffer.offset < buffer.length)
+        /* overflow of int, use INT_MAX if possible */
+        if (needed <= INT_MAX)
         {
-            local_error.position = buffer.offset;
+            newsize = INT_MAX;
         }
-        else if (buffer.length > 0)
+        else
         {
-            local_error.position = buffer.length - 1;
+            return NULL;
         }
+    }
+    else
+    {
+        newsize = needed * 2;
+    }
 
-        if (return_parse_end != NULL)
+    if (p->hooks.reallocate != NULL)
+    {
+        /* reallocate with realloc if available */
+        newbuffer = (unsigned char*)p->hooks.reallocate(p->hooks.user_data, p->buffer, newsize);
+        if (newbuffer == NULL)
         {
-            *return_parse_end = (const char*)local_error.json + local_error.position;
-        }
+            p->hooks.deallocate(p->hooks.user_data, p->buffer);
+            p->length = 0;
+            p->buffer = NULL;
 
-        global_error = local_error;
-    }
+            return NULL;
+        }
+    }
+    else
+    {
+        /* otherwise reallocate manually */
+        newbuffer = (unsigned char*)p->hooks.allocate(p->hooks.user_data, newsize);
+        if (!newbuffer)
+        {
+            p->hooks.deallocate(p->hooks.user_data, p->buffer);
+            p->length = 0;
+            p->buffer = NULL;
 
-    return NULL;
+            return NULL;
+        }
+
+        memcpy(newbuffer, p->buffer, p->offset + 1);
+        p->hooks.deallocate(p->hooks.user_data, p->buffer);
+    }
+    p->length = newsize;
+    p->buffer = newbuffer;
+
+    return newbuffer + p->offset;
 }
 
-/* Default options for cJSON_Parse */
-CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
+/* calculate the new length of the string in a printbuffer and update the offset */
+static void update_offset(printbuffer * const buffer)
 {
-    return cJSON_ParseWithOpts(value, 0, 0);
+    const unsigned char *buffer_pointer = NULL;
+    if ((buffer == NULL) || (buffer->buffer == NULL))
+    {
+        return;
+    }
+    buffer_pointer = buffer->buffer + buffer->offset;
+
+    buffer->offset += strlen((const char*)buffer_pointer);
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_length)
+/* securely comparison of floating-point variables */
+static cJSON_bool compare_double(double a, double b)
 {
-    return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
+    double maxVal = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+    return (fabs(a - b) <= maxVal * DBL_EPSILON);
 }
 
-#define cjson_min(a, b) (((a) < (b)) ? (a) : (b))
+/* Shortest round-trip formatting of doubles with the Grisu2 algorithm (Florian Loitsch, "Printing
+ * Floating-Point Numbers Quickly and Accurately with Integers"). The digits it produces always read back
+ * to the same double, and are the shortest such digits for all but a tiny fraction of values. */
+typedef struct
+{
+    cjson_uint64 f; /* significand */
+    int e; /* binary exponent */
+} diy_fp;
 
-static unsigned char *print(const cJSON * const item, cJSON_bool format, const internal_hooks * const hooks)
+#define DOUBLE_SIGNIFICAND_MASK CJSON_UINT64_C(0x000FFFFFFFFFFFFF)
+#define DOUBLE_HIDDEN_BIT CJSON_UINT64_C(0x0010000000000000)
+#define DOUBLE_EXPONENT_BIAS (0x3FF + 52)
+
+static diy_fp diy_fp_from_double(double number)
 {
-    static const size_t default_buffer_size = 256;
-    printbuffer buffer[1];
-    unsigned char *printed = NULL;
+    diy_fp result;
+    cjson_uint64 bits = 0;
+    int biased_exponent = 0;
 
-    memset(buffer, 0, sizeof(buffer));
+    memcpy(&bits, &number, sizeof(bits));
+    biased_exponent = (int)((bits >> 52) & 0x7FF);
+    if (biased_exponent != 0)
+    {
+        result.f = (bits & DOUBLE_SIGNIFICAND_MASK) + DOUBLE_HIDDEN_BIT;
+        result.e = biased_exponent - DOUBLE_EXPONENT_BIAS;
+    }
+    else
+    {
+        /* subnormal */
+        result.f = bits & DOUBLE_SIGNIFICAND_MASK;
+        result.e = 1 - DOUBLE_EXPONENT_BIAS;
+    }
 
-    /* create buffer */
-    buffer->buffer = (unsigned char*) hooks->allocate(default_buffer_size);
-    buffer->length = default_buffer_size;
-    buffer->format = format;
-    buffer->hooks = *hooks;
-    if (buffer->buffer == NULL)
+    return result;
+}
+
+static diy_fp diy_fp_normalize(diy_fp number)
+{
+    while ((number.f & CJSON_UINT64_C(0x8000000000000000)) == 0)
     {
-        goto fail;
+        number.f <<= 1;
+        number.e--;
     }
 
-    /* print the value */
-    if (!print_value(item, buffer))
+    return number;
+}
+
+/* upper 64 bits of the 128 bit product, rounded */
+static diy_fp diy_fp_multiply(const diy_fp x, const diy_fp y)
+{
+    const cjson_uint64 mask = CJSON_UINT64_C(0xFFFFFFFF);
+    const cjson_uint64 a = x.f >> 32;
+    const cjson_uint64 b = x.f & mask;
+    const cjson_uint64 c = y.f >> 32;
+    const cjson_uint64 d = y.f & mask;
+    const cjson_uint64 ac = a * c;
+    const cjson_uint64 bc = b * c;
+    const cjson_uint64 ad = a * d;
+    const cjson_uint64 bd = b * d;
+    cjson_uint64 middle = (bd >> 32) + (ad & mask) + (bc & mask);
+    diy_fp result;
+
+    middle += CJSON_UINT64_C(1) << 31;
+    result.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+    result.e = x.e + y.e + 64;
+
+    return result;
+}
+
+/* the boundaries m- and m+ halfway to the neighbouring doubles, with the exponent of m+ */
+static void diy_fp_normalized_boundaries(const diy_fp number, diy_fp * const minus, diy_fp * const plus)
+{
+    diy_fp upper;
+    diy_fp lower;
+
+    upper.f = (number.f << 1) + 1;
+    upper.e = number.e - 1;
+    while ((upper.f & (DOUBLE_HIDDEN_BIT << 1)) == 0)
     {
-        goto fail;
+        upper.f <<= 1;
+        upper.e--;
     }
-    update_offset(buffer);
+    upper.f <<= (64 - 52 - 2);
+    upper.e -= (64 - 52 - 2);
 
-    /* check if reallocate is available */
-    if (hooks->reallocate != NULL)
+    /* the lower boundary is closer if number is a power of two */
+    if (number.f == DOUBLE_HIDDEN_BIT)
     {
-        printed = (unsigned char*) hooks->reallocate(buffer->buffer, buffer->offset + 1);
-        if (printed == NULL) {
-            goto fail;
-        }
-        buffer->buffer = NULL;
+        lower.f = (number.f << 2) - 1;
+        lower.e = number.e - 2;
     }
-    else /* otherwise copy the JSON over to a new buffer */
+    else
     {
-        printed = (unsigned char*) hooks->allocate(buffer->offset + 1);
-        if (printed == NULL)
-        {
-            goto fail;
-        }
-        memcpy(printed, buffer->buffer, cjson_min(buffer->length, buffer->offset + 1));
-        printed[buffer->offset] = '\0'; /* just to be sure */
-
-        /* free the buffer */
-        hooks->deallocate(buffer->buffer);
-        buffer->buffer = NULL;
+        lower.f = (number.f << 1) - 1;
+        lower.e = number.e - 1;
     }
+    lower.f <<= lower.e - upper.e;
+    lower.e = upper.e;
 
-    return printed;
+    *minus = lower;
+    *plus = upper;
+}
 
-fail:
-    if (buffer->buffer != NULL)
+/* normalized 10^k for k = -348, -340, ..., 340 */
+static diy_fp grisu_cached_power(int exponent, int * const decimal_exponent)
+{
+    static const diy_fp cached_powers[] = {
+        { CJSON_UINT64_C(0xfa8fd5a0081c0288), -1220 }, { CJSON_UINT64_C(0xbaaee17fa23ebf76), -1193 }, { CJSON_UINT64_C(0x8b16fb203055ac76), -1166 },
+        { CJSON_UINT64_C(0xcf42894a5dce35ea), -1140 }, { CJSON_UINT64_C(0x9a6bb0aa55653b2d), -1113 }, { CJSON_UINT64_C(0xe61acf033d1a45df), -1087 },
+        { CJSON_UINT64_C(0xab70fe17c79ac6ca), -1060 }, { CJSON_UINT64_C(0xff77b1fcbebcdc4f), -1034 }, { CJSON_UINT64_C(0xbe5691ef416bd60c), -1007 },
+        { CJSON_UINT64_C(0x8dd01fad907ffc3c), -980 }, { CJSON_UINT64_C(0xd3515c2831559a83), -954 }, { CJSON_UINT64_C(0x9d71ac8fada6c9b5), -927 },
+        { CJSON_UINT64_C(0xea9c227723ee8bcb), -901 }, { CJSON_UINT64_C(0xaecc49914078536d), -874 }, { CJSON_UINT64_C(0x823c12795db6ce57), -847 },
+        { CJSON_UINT64_C(0xc21094364dfb5637), -821 }, { CJSON_UINT64_C(0x9096ea6f3848984f), -794 }, { CJSON_UINT64_C(0xd77485cb25823ac7), -768 },
+        { CJSON_UINT64_C(0xa086cfcd97bf97f4), -741 }, { CJSON_UINT64_C(0xef340a98172aace5), -715 }, { CJSON_UINT64_C(0xb23867fb2a35b28e), -688 },
+        { CJSON_UINT64_C(0x84c8d4dfd2c63f3b), -661 }, { CJSON_UINT64_C(0xc5dd44271ad3cdba), -635 }, { CJSON_UINT64_C(0x936b9fcebb25c996), -608 },
+        { CJSON_UINT64_C(0xdbac6c247d62a584), -582 }, { CJSON_UINT64_C(0xa3ab66580d5fdaf6), -555 }, { CJSON_UINT64_C(0xf3e2f893dec3f126), -529 },
+        { CJSON_UINT64_C(0xb5b5ada8aaff80b8), -502 }, { CJSON_UINT64_C(0x87625f056c7c4a8b), -475 }, { CJSON_UINT64_C(0xc9bcff6034c13053), -449 },
+        { CJSON_UINT64_C(0x964e858c91ba2655), -422 }, { CJSON_UINT64_C(0xdff9772470297ebd), -396 }, { CJSON_UINT64_C(0xa6dfbd9fb8e5b88f), -369 },
+        { CJSON_UINT64_C(0xf8a95fcf88747d94), -343 }, { CJSON_UINT64_C(0xb94470938fa89bcf), -316 }, { CJSON_UINT64_C(0x8a08f0f8bf0f156b), -289 },
+        { CJSON_UINT64_C(0xcdb02555653131b6), -263 }, { CJSON_UINT64_C(0x993fe2c6d07b7fac), -236 }, { CJSON_UINT64_C(0xe45c10c42a2b3b06), -210 },
+        { CJSON_UINT64_C(0xaa242499697392d3), -183 }, { CJSON_UINT64_C(0xfd87b5f28300ca0e), -157 }, { CJSON_UINT64_C(0xbce5086492111aeb), -130 },
+        { CJSON_UINT64_C(0x8cbccc096f5088cc), -103 }, { CJSON_UINT64_C(0xd1b71758e219652c), -77 }, { CJSON_UINT64_C(0x9c40000000000000), -50 },
+        { CJSON_UINT64_C(0xe8d4a51000000000), -24 }, { CJSON_UINT64_C(0xad78ebc5ac620000), 3 }, { CJSON_UINT64_C(0x813f3978f8940984), 30 },
+        { CJSON_UINT64_C(0xc097ce7bc90715b3), 56 }, { CJSON_UINT64_C(0x8f7e32ce7bea5c70), 83 }, { CJSON_UINT64_C(0xd5d238a4abe98068), 109 },
+        { CJSON_UINT64_C(0x9f4f2726179a2245), 136 }, { CJSON_UINT64_C(0xed63a231d4c4fb27), 162 }, { CJSON_UINT64_C(0xb0de65388cc8ada8), 189 },
+        { CJSON_UINT64_C(0x83c7088e1aab65db), 216 }, { CJSON_UINT64_C(0xc45d1df942711d9a), 242 }, { CJSON_UINT64_C(0x924d692ca61be758), 269 },
+        { CJSON_UINT64_C(0xda01ee641a708dea), 295 }, { CJSON_UINT64_C(0xa26da3999aef774a), 322 }, { CJSON_UINT64_C(0xf209787bb47d6b85), 348 },
+        { CJSON_UINT64_C(0xb454e4a179dd1877), 375 }, { CJSON_UINT64_C(0x865b86925b9bc5c2), 402 }, { CJSON_UINT64_C(0xc83553c5c8965d3d), 428 },
+        { CJSON_UINT64_C(0x952ab45cfa97a0b3), 455 }, { CJSON_UINT64_C(0xde469fbd99a05fe3), 481 }, { CJSON_UINT64_C(0xa59bc234db398c25), 508 },
+        { CJSON_UINT64_C(0xf6c69a72a3989f5c), 534 }, { CJSON_UINT64_C(0xb7dcbf5354e9bece), 561 }, { CJSON_UINT64_C(0x88fcf317f22241e2), 588 },
+        { CJSON_UINT64_C(0xcc20ce9bd35c78a5), 614 }, { CJSON_UINT64_C(0x98165af37b2153df), 641 }, { CJSON_UINT64_C(0xe2a0b5dc971f303a), 667 },
+        { CJSON_UINT64_C(0xa8d9d1535ce3b396), 694 }, { CJSON_UINT64_C(0xfb9b7cd9a4a7443c), 720 }, { CJSON_UINT64_C(0xbb764c4ca7a44410), 747 },
+        { CJSON_UINT64_C(0x8bab8eefb6409c1a), 774 }, { CJSON_UINT64_C(0xd01fef10a657842c), 800 }, { CJSON_UINT64_C(0x9b10a4e5e9913129), 827 },
+        { CJSON_UINT64_C(0xe7109bfba19c0c9d), 853 }, { CJSON_UINT64_C(0xac2820d9623bf429), 880 }, { CJSON_UINT64_C(0x80444b5e7aa7cf85), 907 },
+        { CJSON_UINT64_C(0xbf21e44003acdd2d), 933 }, { CJSON_UINT64_C(0x8e679c2f5e44ff8f), 960 }, { CJSON_UINT64_C(0xd433179d9c8cb841), 986 },
+        { CJSON_UINT64_C(0x9e19db92b4e31ba9), 1013 }, { CJSON_UINT64_C(0xeb96bf6ebadf77d9), 1039 }, { CJSON_UINT64_C(0xaf87023b9bf0ee6b), 1066 }
+    };
+    /* smallest k with 10^k * 2^exponent >= 2^-60 */
+    double dk = ((-61 - exponent) * 0.30102999566398114) + 347;
+    int k = (int)dk;
+    size_t index = 0;
+
+    if ((dk - k) > 0.0)
+    {
+        k++;
+    }
+    index = (size_t)((k >> 3) + 1);
+    *decimal_exponent = -(-348 + (int)(index << 3));
+
+    return cached_powers[index];
+}
+
+static void grisu_round(unsigned char * const digits, size_t length, cjson_uint64 delta, cjson_uint64 rest, cjson_uint64 ten_kappa, cjson_uint64 distance)
+{
+    while ((rest < distance) && ((delta - rest) >= ten_kappa) && (((rest + ten_kappa) < distance) || ((distance - rest) > (rest + ten_kappa - distance))))
     {
-        hooks->deallocate(buffer->buffer);
-        buffer->buffer = NULL;
+        digits[length - 1]--;
+        rest += ten_kappa;
     }
+}
 
-    if (printed != NULL)
+static int count_decimal_digits(unsigned int number)
+{
+    int count = 1;
+    while (number >= 10)
     {
-        hooks->deallocate(printed);
-        printed = NULL;
+        number /= 10;
+        count++;
     }
 
-    return NULL;
+    return count;
 }
 
-/* Render a cJSON item/entity/structure to text. */
-CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item)
+static size_t grisu_generate_digits(const diy_fp w, const diy_fp upper, cjson_uint64 delta, unsigned char * const digits, int * const decimal_exponent)
 {
-    return (char*)print(item, true, &global_hooks);
+    static const cjson_uint64 powers_of_ten[] = {
+        CJSON_UINT64_C(1), CJSON_UINT64_C(10), CJSON_UINT64_C(100), CJSON_UINT64_C(1000), CJSON_UINT64_C(10000), CJSON_UINT64_C(100000), CJSON_UINT64_C(1000000), CJSON_UINT64_C(10000000), CJSON_UINT64_C(100000000),
+        CJSON_UINT64_C(1000000000), CJSON_UINT64_C(10000000000), CJSON_UINT64_C(100000000000), CJSON_UINT64_C(1000000000000), CJSON_UINT64_C(10000000000000),
+        CJSON_UINT64_C(100000000000000), CJSON_UINT64_C(1000000000000000), CJSON_UINT64_C(10000000000000000), CJSON_UINT64_C(100000000000000000),
+        CJSON_UINT64_C(1000000000000000000), CJSON_UINT64_C(10000000000000000000)
+    };
+    const int shift = -upper.e;
+    const cjson_uint64 one = CJSON_UINT64_C(1) << shift;
+    const cjson_uint64 distance = upper.f - w.f;
+    unsigned int integral = (unsigned int)(upper.f >> shift);
+    cjson_uint64 fraction = upper.f & (one - 1);
+    int kappa = count_decimal_digits(integral);
+    size_t length = 0;
+
+    while (kappa > 0)
+    {
+        unsigned int divisor = (unsigned int)powers_of_ten[kappa - 1];
+        unsigned int digit = integral / divisor;
+        cjson_uint64 rest = 0;
+
+        integral %= divisor;
+        if ((digit != 0) || (length != 0))
+        {
+            digits[length++] = (unsigned char)('0' + digit);
+        }
+        kappa--;
+
+        rest = ((cjson_uint64)integral << shift) + fraction;
+        if (rest <= delta)
+        {
+            *decimal_exponent += kappa;
+            grisu_round(digits, length, delta, rest, powers_of_ten[kappa] << shift, distance);
+            return length;
+        }
+    }
+
+    for (;;)
+    {
+        unsigned int digit = 0;
+
+        fraction *= 10;
+        delta *= 10;
+        digit = (unsigned int)(fraction >> shift);
+        if ((digit != 0) || (length != 0))
+        {
+            digits[length++] = (unsigned char)('0' + digit);
+        }
+        fraction &= one - 1;
+        kappa--;
+
+        if (fraction < delta)
+        {
+            *decimal_exponent += kappa;
+            grisu_round(digits, length, delta, fraction, one, (-kappa < 20) ? (distance * powers_of_ten[-kappa]) : 0);
+            return length;
+        }
+    }
 }
 
-CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item)
+/* writes the shortest digits of a positive, finite number, value = digits * 10^decimal_exponent */
+static size_t grisu2(double number, unsigned char * const digits, int * const decimal_exponent)
 {
-    return (char*)print(item, false, &global_hooks);
+    const diy_fp value = diy_fp_from_double(number);
+    diy_fp minus;
+    diy_fp plus;
+    diy_fp cached_power;
+    diy_fp w;
+
+    diy_fp_normalized_boundaries(value, &minus, &plus);
+    cached_power = grisu_cached_power(plus.e, decimal_exponent);
+    w = diy_fp_multiply(diy_fp_normalize(value), cached_power);
+    plus = diy_fp_multiply(plus, cached_power);
+    minus = diy_fp_multiply(minus, cached_power);
+    /* stay strictly inside the rounding interval, the products are off by at most one unit */
+    minus.f++;
+    plus.f--;
+
+    return grisu_generate_digits(w, plus, plus.f - minus.f, digits, decimal_exponent);
 }
 
-CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt)
+/* write an int, returns the number of characters */
+static size_t print_integer(int integer, unsigned char * const output)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    unsigned char reversed[12];
+    unsigned int magnitude = (integer < 0) ? (0U - (unsigned int)integer) : (unsigned int)integer;
+    size_t length = 0;
+    size_t i = 0;
 
-    if (prebuffer < 0)
+    do
     {
-        return NULL;
+        reversed[i++] = (unsigned char)('0' + (magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (integer < 0)
+    {
+        output[length++] = '-';
+    }
+    while (i > 0)
+    {
+        output[length++] = reversed[--i];
     }
 
-    p.buffer = (unsigned char*)global_hooks.allocate((size_t)prebuffer);
-    if (!p.buffer)
+    return length;
+}
+
+/* Lay the digits out like printf's "%.15g" would, e.g. 0.0001, 123.456, 1e+15, 1.5e-07.
+ * Returns the number of characters, at most 25. */
+static size_t format_double(double number, unsigned char * const output)
+{
+    unsigned char digits[20];
+    int decimal_exponent = 0;
+    int exponent = 0; /* decimal exponent of the first digit */
+    size_t digit_count = 0;
+    size_t length = 0;
+    size_t i = 0;
+
+    if (number < 0)
     {
-        return NULL;
+        output[length++] = '-';
+        number = -number;
     }
 
-    p.length = (size_t)prebuffer;
-    p.offset = 0;
-    p.noalloc = false;
-    p.format = fmt;
-    p.hooks = global_hooks;
+    digit_count = grisu2(number, digits, &decimal_exponent);
+    exponent = (int)digit_count + decimal_exponent - 1;
 
-    if (!print_value(item, &p))
+    if ((exponent < -4) || (exponent >= 15))
     {
-        global_hooks.deallocate(p.buffer);
-        p.buffer = NULL;
-        return NULL;
+        /* d.ddde+XX */
+        output[length++] = digits[0];
+        if (digit_count > 1)
+        {
+            output[length++] = '.';
+            memcpy(output + length, digits + 1, digit_count - 1);
+            length += digit_count - 1;
+        }
+        output[length++] = 'e';
+        output[length++] = (exponent < 0) ? '-' : '+';
+        if (exponent < 0)
+        {
+            exponent = -exponent;
+        }
+        if (exponent >= 100)
+        {
+            output[length++] = (unsigned char)('0' + (exponent / 100));
+        }
+        output[length++] = (unsigned char)('0' + ((exponent / 10) % 10));
+        output[length++] = (unsigned char)('0' + (exponent % 10));
+    }
+    else if (decimal_exponent >= 0)
+    {
+        /* integer, pad with zeros */
+        memcpy(output + length, digits, digit_count);
+        length += digit_count;
+        for (i = 0; i < (size_t)decimal_exponent; i++)
+        {
+            output[length++] = '0';
+        }
+    }
+    else if (exponent >= 0)
+    {
+        /* the decimal point is inside the digits */
+        memcpy(output + length, digits, (size_t)exponent + 1);
+        length += (size_t)exponent + 1;
+        output[length++] = '.';
+        memcpy(output + length, digits + exponent + 1, digit_count - (size_t)exponent - 1);
+        length += digit_count - (size_t)exponent - 1;
+    }
+    else
+    {
+        /* 0.000ddd */
+        output[length++] = '0';
+        output[length++] = '.';
+        for (i = 0; i < (size_t)(-exponent - 1); i++)
+        {
+            output[length++] = '0';
+        }
+        memcpy(output + length, digits, digit_count);
+        length += digit_count;
     }
 
-    return (char*)p.buffer;
+    return length;
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format)
+/* Render the number nicely from the given item into a string. */
+static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    unsigned char *output_pointer = NULL;
+    unsigned char number_buffer[26]; /* longest possible number */
+    double d = item->valuedouble;
+    size_t length = 0;
 
-    if ((length < 0) || (buffer == NULL))
+    if (output_buffer == NULL)
     {
         return false;
     }
 
-    p.buffer = (unsigned char*)buffer;
-    p.length = (size_t)length;
-    p.offset = 0;
-    p.noalloc = true;
-    p.format = format;
-    p.hooks = global_hooks;
+    /* This checks for NaN and Infinity */
+    if (isnan(d) || isinf(d))
+    {
+        memcpy(number_buffer, "null", 4);
+        length = 4;
+    }
+    else if(d == (double)item->valueint)
+    {
+        length = print_integer(item->valueint, number_buffer);
+    }
+    else
+    {
+        length = format_double(d, number_buffer);
+    }
 
-    return print_value(item, &p);
+    /* only reserve what is needed, so that a buffer of cJSON_PrintedLength bytes is enough */
+    output_pointer = ensure(output_buffer, length + 1);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+    memcpy(output_pointer, number_buffer, length);
+    output_pointer[length] = '\0';
+
+    output_buffer->offset += length;
+
+    return true;
+}
+
+/* value of a hex digit, 0xFF for everything else */
+static const unsigned char hex_values[256] =
+{
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+/* parse 4 digit hexadecimal number, returns 0 if one of the four characters isn't a hex digit */
+static unsigned parse_hex4(const unsigned char * const input)
+{
+    const unsigned int digit0 = hex_values[input[0]];
+    const unsigned int digit1 = hex_values[input[1]];
+    const unsigned int digit2 = hex_values[input[2]];
+    const unsigned int digit3 = hex_values[input[3]];
+
+    /* a single check for all four, 0xFF has the high bit set */
+    if (((digit0 | digit1 | digit2 | digit3) & 0x80) != 0)
+    {
+        return 0;
+    }
+
+    return (digit0 << 12) | (digit1 << 8) | (digit2 << 4) | digit3;
+}
+
+/* converts a UTF-16 literal to UTF-8
+ * A literal can be one or two sequences of the form \uXXXX */
+static unsigned char utf16_literal_to_utf8(const unsigned char * const input_pointer, const unsigned char * const input_end, unsigned char **output_pointer)
+{
+    long unsigned int codepoint = 0;
+    unsigned int first_code = 0;
+    const unsigned char *first_sequence = input_pointer;
+    unsigned char utf8_length = 0;
+    unsigned char utf8_position = 0;
+    unsigned char sequence_length = 0;
+    unsigned char first_byte_mark = 0;
+
+    if ((input_end - first_sequence) < 6)
+    {
+        /* input ends unexpectedly */
+        goto fail;
+    }
+
+    /* get the first utf16 sequence */
+    first_code = parse_hex4(first_sequence + 2);
+
+    /* check that the code is valid */
+    if (((first_code >= 0xDC00) && (first_code <= 0xDFFF)))
+    {
+        goto fail;
+    }
+
+    /* UTF16 surrogate pair */
+    if ((first_code >= 0xD800) && (first_code <= 0xDBFF))
+    {
+        const unsigned char *second_sequence = first_sequence + 6;
+        unsigned int second_code = 0;
+        sequence_length = 12; /* \uXXXX\uXXXX */
+
+        if ((input_end - second_sequence) < 6)
+        {
+            /* input ends unexpectedly */
+            goto fail;
+        }
+
+        if ((second_sequence[0] != '\\') || (second_sequence[1] != 'u'))
+        {
+            /* missing second half of the surrogate pair */
+            goto fail;
+        }
+
+        /* get the second utf16 sequence */
+        second_code = parse_hex4(second_sequence + 2);
+        /* check that the code is valid */
+        if ((second_code < 0xDC00) || (second_code > 0xDFFF))
+        {
+            /* invalid second half of the surrogate pair */
+            goto fail;
+        }
+
+
+        /* calculate the unicode codepoint from the surrogate pair */
+        codepoint = 0x10000 + (((first_code & 0x3FF) << 10) | (second_code & 0x3FF));
+    }
+    else
+    {
+        sequence_length = 6; /* \uXXXX */
+        codepoint = first_code;
+    }
+
+    /* encode as UTF-8
+     * takes at maximum 4 bytes to encode:
+     * 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx */
+    if (codepoint < 0x80)
+    {
+        /* normal ascii, encoding 0xxxxxxx */
+        (*output_pointer)[0] = (unsigned char)codepoint;
+        *output_pointer += 1;
+        return sequence_length;
+    }
+    else if (codepoint < 0x800)
+    {
+        /* two bytes, encoding 110xxxxx 10xxxxxx, written directly because that is all of Latin, Greek and Cyrillic */
+        (*output_pointer)[0] = (unsigned char)(0xC0 | (codepoint >> 6));
+        (*output_pointer)[1] = (unsigned char)(0x80 | (codepoint & 0x3F));
+        *output_pointer += 2;
+        return sequence_length;
+    }
+    else if (codepoint < 0x10000)
+    {
+        /* three bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx */
+        utf8_length = 3;
+        first_byte_mark = 0xE0; /* 11100000 */
+    }
+    else if (codepoint <= 0x10FFFF)
+    {
+        /* four bytes, encoding 1110xxxx 10xxxxxx 10xxxxxx 10xxxxxx */
+        utf8_length = 4;
+        first_byte_mark = 0xF0; /* 11110000 */
+    }
+    else
+    {
+        /* invalid unicode codepoint */
+        goto fail;
+    }
+
+    /* encode as utf8 */
+    for (utf8_position = (unsigned char)(utf8_length - 1); utf8_position > 0; utf8_position--)
+    {
+        /* 10xxxxxx */
+        (*output_pointer)[utf8_position] = (unsigned char)((codepoint | 0x80) & 0xBF);
+        codepoint >>= 6;
+    }
+    /* encode first byte */
+    if (utf8_length > 1)
+    {
+        (*output_pointer)[0] = (unsigned char)((codepoint | first_byte_mark) & 0xFF);
+    }
+    else
+    {
+        (*output_pointer)[0] = (unsigned char)(codepoint & 0x7F);
+    }
+
+    *output_pointer += utf8_length;
+
+    return sequence_length;
+
+fail:
+    return 0;
+}
+
+/* Parse the input text into an unescaped cinput, and populate item. */
+static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer)
+{
+    const unsigned char *input_pointer = buffer_at_offset(input_buffer) + 1;
+    const unsigned char *input_end = buffer_at_offset(input_buffer) + 1;
+    unsigned char *output_pointer = NULL;
+    unsigned char *output = NULL;
+
+    /* not a string */
+    if (buffer_at_offset(input_buffer)[0] != '\"')
+    {
+        parse_fail(input_buffer, cJSON_ParseErrorUnexpectedCharacter);
+        goto fail;
+    }
+
+    {
+        const unsigned char * const content_end = input_buffer->content + input_buffer->length;
+        /* calculate approximate size of the output (overestimate) */
+        size_t allocation_length = 0;
+        cJSON_bool has_escapes = false;
+
+        /* usually the first '\"' or '\\' is the closing quote */
+        input_end += scan_string_special(input_end, (size_t)(content_end - input_end));
+        if ((input_end < content_end) && (*input_end == '\\'))
+        {
+            /* Find the closing quote without stopping at every escape sequence, which is slow for strings
+             * made of \uXXXX: a quote is escaped if it follows an odd number of backslashes. */
+            has_escapes = true;
+            while (input_end < content_end)
+            {
+                const unsigned char *backslash = NULL;
+
+                input_end = (const unsigned char*)memchr(input_end, '\"', (size_t)(content_end - input_end));
+                if (input_end == NULL)
+                {
+                    input_end = content_end;
+                    break;
+                }
+
+                backslash = input_end;
+                while ((backslash > input_pointer) && (backslash[-1] == '\\'))
+                {
+                    backslash--;
+                }
+                if (((input_end - backslash) % 2) == 0)
+                {
+                    break;
+                }
+                input_end++;
+            }
+        }
+        if ((input_end >= content_end) || (*input_end != '\"'))
+        {
+            parse_fail(input_buffer, cJSON_ParseErrorUnexpectedEnd);
+            goto fail; /* string ended unexpectedly */
+        }
+
+        if ((input_buffer->in_place != NULL) && !has_escapes)
+        {
+            /* nothing to unescape, terminate the string where it is */
+            output = input_buffer->in_place + (input_pointer - input_buffer->content);
+            input_buffer->in_place[input_end - input_buffer->content] = '\0';
+
+            item->type = cJSON_String | cJSON_IsReference;
+            item->valuestring = (char*)output;
+
+            input_buffer->offset = (size_t) (input_end - input_buffer->content);
+            input_buffer->offset++;
+
+            return true;
+        }
+
+        /* This is at most how much we need for the output, every escape sequence is longer than what it stands for */
+        allocation_length = (size_t) (input_end - input_pointer);
+        output = (unsigned char*)parse_allocate(input_buffer, allocation_length + sizeof(""));
+        if (output == NULL)
+        {
+            parse_fail(input_buffer, cJSON_ParseErrorOutOfMemory);
+            goto fail; /* allocation failure */
+        }
+    }
+
+    output_pointer = output;
+    /* loop through the string literal */
+    while (input_pointer < input_end)
+    {
+        if (*input_pointer != '\\')
+        {
+            /* copy everything up to the next escape sequence at once */
+            const unsigned char *escape = (const unsigned char*)memchr(input_pointer, '\\', (size_t)(input_end - input_pointer));
+            size_t run_length = (size_t)(((escape != NULL) ? escape : input_end) - input_pointer);
+            memcpy(output_pointer, input_pointer, run_length);
+            output_pointer += run_length;
+            input_pointer += run_length;
+        }
+        /* escape sequence */
+        else
+        {
+            unsigned char sequence_length = 2;
+            if ((input_end - input_pointer) < 1)
+            {
+                parse_fail(input_buffer, cJSON_ParseErrorInvalidString);
+                goto fail;
+            }
+
+            switch (input_pointer[1])
+            {
+                case 'b':
+                    *output_pointer++ = '\b';
+                    break;
+                case 'f':
+                    *output_pointer++ = '\f';
+                    break;
+                case 'n':
+                    *output_pointer++ = '\n';
+                    break;
+                case 'r':
+                    *output_pointer++ = '\r';
+                    break;
+                case 't':
+                    *output_pointer++ = '\t';
+                    break;
+                case '\"':
+                case '\\':
+                case '/':
+                    *output_pointer++ = input_pointer[1];
+                    break;
+
+                /* UTF-16 literal */
+                case 'u':
+                    sequence_length = utf16_literal_to_utf8(input_pointer, input_end, &output_pointer);
+                    if (sequence_length == 0)
+                    {
+                        /* failed to convert UTF16-literal to UTF-8 */
+                        parse_fail(input_buffer, cJSON_ParseErrorInvalidString);
+                        goto fail;
+                    }
+                    break;
+
+                default:
+                    parse_fail(input_buffer, cJSON_ParseErrorInvalidString);
+                    goto fail;
+            }
+            input_pointer += sequence_length;
+        }
+    }
+
+    /* zero terminate the output */
+    *output_pointer = '\0';
+
+    item->type = cJSON_String;
+    item->valuestring = (char*)output;
+
+    input_buffer->offset = (size_t) (input_end - input_buffer->content);
+    input_buffer->offset++;
+
+    return true;
+
+fail:
+    if (output != NULL)
+    {
+        parse_deallocate(input_buffer, output);
+        output = NULL;
+    }
+
+    if (input_pointer != NULL)
+    {
+        input_buffer->offset = (size_t)(input_pointer - input_buffer->content);
+    }
+
+    return false;
+}
+
+/* second character of the short escape sequence of a control character, 0 for the ones printed as \u00XX */
+static const unsigned char control_escapes[32] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 'b', 't', 'n', 0, 'f', 'r', 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/* length of the escape sequence of a byte found by scan_escape_special */
+#define escape_length(character) ((((character) > 31) || (control_escapes[(character)] != 0)) ? 2 : 6)
+
+/* Render the cstring provided to an escaped version that can be printed. */
+static cJSON_bool print_string_ptr(const unsigned char * const input, printbuffer * const output_buffer)
+{
+    static const unsigned char hex_digits[] = "0123456789abcdef";
+    unsigned char *output = NULL;
+    unsigned char *output_pointer = NULL;
+    size_t input_length = 0;
+    size_t output_length = 0;
+    size_t position = 0;
+    /* numbers of additional characters needed for escaping */
+    size_t escape_characters = 0;
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    /* empty string */
+    if (input == NULL)
+    {
+        output = ensure(output_buffer, sizeof("\"\""));
+        if (output == NULL)
+        {
+            return false;
+        }
+        strcpy((char*)output, "\"\"");
+
+        return true;
+    }
+
+    /* count the additional characters, jumping from one byte that needs escaping to the next */
+    input_length = strlen((const char*)input);
+    for (position = scan_escape_special(input, input_length); position < input_length; position += 1 + scan_escape_special(input + position + 1, input_length - position - 1))
+    {
+        escape_characters += (size_t)escape_length(input[position]) - 1;
+    }
+    output_length = input_length + escape_characters;
+
+    output = ensure(output_buffer, output_length + sizeof("\"\""));
+    if (output == NULL)
+    {
+        return false;
+    }
+
+    /* no characters have to be escaped */
+    if (escape_characters == 0)
+    {
+        output[0] = '\"';
+        memcpy(output + 1, input, output_length);
+        output[output_length + 1] = '\"';
+        output[output_length + 2] = '\0';
+
+        return true;
+    }
+
+    output[0] = '\"';
+    output_pointer = output + 1;
+    /* copy the runs between the escaped bytes in one go */
+    position = 0;
+    while (position < input_length)
+    {
+        const size_t run = scan_escape_special(input + position, input_length - position);
+        unsigned char character = 0;
+
+        memcpy(output_pointer, input + position, run);
+        output_pointer += run;
+        position += run;
+        if (position >= input_length)
+        {
+            break;
+        }
+
+        character = input[position++];
+        *output_pointer++ = '\\';
+        if (character > 31)
+        {
+            /* '\"' or '\\' */
+            *output_pointer++ = character;
+        }
+        else if (control_escapes[character] != 0)
+        {
+            *output_pointer++ = control_escapes[character];
+        }
+        else
+        {
+            /* escape and print as unicode codepoint */
+            output_pointer[0] = 'u';
+            output_pointer[1] = '0';
+            output_pointer[2] = '0';
+            output_pointer[3] = hex_digits[character >> 4];
+            output_pointer[4] = hex_digits[character & 15];
+            output_pointer += 5;
+        }
+    }
+    output[output_length + 1] = '\"';
+    output[output_length + 2] = '\0';
+
+    return true;
+}
+
+/* Invoke print_string_ptr (which is useful) on an item. */
+static cJSON_bool print_string(const cJSON * const item, printbuffer * const p)
+{
+    return print_string_ptr((unsigned char*)item->valuestring, p);
+}
+
+/* Predeclare these prototypes. */
+static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer);
+static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer);
+static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer);
+static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer);
+
+/* Utility to jump whitespace and cr/lf */
+static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
+{
+    if ((buffer == NULL) || (buffer->content == NULL))
+    {
+        return NULL;
+    }
+
+    if (cannot_access_at_index(buffer, 0))
+    {
+        return buffer;
+    }
+
+    /* most values are directly followed by the next token */
+    if (buffer_at_offset(buffer)[0] > 32)
+    {
+        return buffer;
+    }
+
+    buffer->offset += scan_whitespace(buffer_at_offset(buffer), buffer->length - buffer->offset);
+
+    if (buffer->offset == buffer->length)
+    {
+        buffer->offset--;
+    }
+
+    return buffer;
+}
+
+/* skip the UTF-8 BOM (byte order mark) if it is at the beginning of a buffer */
+static parse_buffer *skip_utf8_bom(parse_buffer * const buffer)
+{
+    if ((buffer == NULL) || (buffer->content == NULL) || (buffer->offset != 0))
+    {
+        return NULL;
+    }
+
+    if (can_access_at_index(buffer, 4) && (strncmp((const char*)buffer_at_offset(buffer), "\xEF\xBB\xBF", 3) == 0))
+    {
+        buffer->offset += 3;
+    }
+
+    return buffer;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    size_t buffer_length;
+
+    if (NULL == value)
+    {
+        return NULL;
+    }
+
+    /* Adding null character size due to require_null_terminated. */
+    buffer_length = strlen(value) + sizeof("");
+
+    return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
+}
+
+/* record where a parse failed */
+static void set_parse_error(const char * const value, const parse_buffer * const buffer, const char ** const return_parse_end, error * const parse_error)
+{
+    error local_error;
+    local_error.json = (const unsigned char*)value;
+    local_error.position = 0;
+    local_error.reason = (buffer->error != cJSON_ParseErrorNone) ? buffer->error : cJSON_ParseErrorUnexpectedCharacter;
+
+    if (buffer->offset < buffer->length)
+    {
+        local_error.position = buffer->offset;
+    }
+    else if (buffer->length > 0)
+    {
+        local_error.position = buffer->length - 1;
+    }
+
+    if (return_parse_end != NULL)
+    {
+        *return_parse_end = (const char*)local_error.json + local_error.position;
+    }
+
+    *parse_error = local_error;
+}
+
+/* Parse an object - create a new root, and populate. Failures are recorded in parse_error, which is
+ * global_error for the public entry points. */
+static cJSON *parse_document(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, cJSON_Arena * const arena, unsigned char * const in_place, const internal_hooks * const hooks, error * const parse_error)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0, NULL }, NULL, NULL, 0 };
+    cJSON *item = NULL;
+    cJSON_ArenaBlock *arena_mark = NULL;
+    size_t arena_mark_used = 0;
+
+    /* reset error position */
+    parse_error->json = NULL;
+    parse_error->position = 0;
+    parse_error->reason = cJSON_ParseErrorNone;
+
+    if (value == NULL || 0 == buffer_length)
+    {
+        parse_error->reason = cJSON_ParseErrorNoInput;
+        goto fail;
+    }
+
+    buffer.content = (const unsigned char*)value;
+    buffer.length = buffer_length;
+    buffer.offset = 0;
+    buffer.hooks = *hooks;
+    buffer.arena = arena;
+    buffer.in_place = in_place;
+
+    if (arena != NULL)
+    {
+        /* remember where the arena was, to roll back a failed parse */
+        arena_mark = arena->current;
+        arena_mark_used = (arena_mark != NULL) ? arena_mark->used : 0;
+    }
+
+    item = parse_new_item(&buffer);
+    if (item == NULL) /* memory fail */
+    {
+        parse_fail(&buffer, cJSON_ParseErrorOutOfMemory);
+        goto fail;
+    }
+
+    if (!parse_value(item, buffer_skip_whitespace(skip_utf8_bom(&buffer))))
+    {
+        /* parse failure. ep is set. */
+        goto fail;
+    }
+    parse_mark_item(&buffer, item);
+
+    /* if we require null-terminated JSON without appended garbage, skip and then check for a null terminator */
+    if (require_null_terminated)
+    {
+        buffer_skip_whitespace(&buffer);
+        if ((buffer.offset >= buffer.length) || buffer_at_offset(&buffer)[0] != '\0')
+        {
+            parse_fail(&buffer, (buffer.offset >= buffer.length) ? cJSON_ParseErrorUnexpectedEnd : cJSON_ParseErrorTrailingData);
+            goto fail;
+        }
+    }
+    if (return_parse_end)
+    {
+        *return_parse_end = (const char*)buffer_at_offset(&buffer);
+    }
+
+    return item;
+
+fail:
+    if (item != NULL)
+    {
+        parse_delete(&buffer, item);
+    }
+
+    if (arena != NULL)
+    {
+        arena->current = (arena_mark != NULL) ? arena_mark : arena->blocks;
+        if (arena->current != NULL)
+        {
+            arena->current->used = arena_mark_used;
+        }
+    }
+
+    if (value != NULL)
+    {
+        set_parse_error(value, &buffer, return_parse_end, parse_error);
+    }
+
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_document(value, buffer_length, return_parse_end, require_null_terminated, NULL, NULL, &global_hooks, &global_error);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithError(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, cJSON_ParseError *parse_error)
+{
+    error local_error = { NULL, 0, 0 };
+    cJSON *item = parse_document(value, buffer_length, return_parse_end, require_null_terminated, NULL, NULL, &global_hooks, &local_error);
+
+    if (parse_error != NULL)
+    {
+        memset(parse_error, '\0', sizeof(cJSON_ParseError));
+        parse_error->reason = local_error.reason;
+        if (item == NULL)
+        {
+            const unsigned char *line_start = local_error.json;
+            const unsigned char *newline = NULL;
+
+            parse_error->offset = local_error.position;
+            parse_error->line = 1;
+            /* count the lines in front of the error */
+            while ((line_start != NULL) && ((newline = (const unsigned char*)memchr(line_start, '\n', (size_t)((local_error.json + local_error.position) - line_start))) != NULL))
+            {
+                parse_error->line++;
+                line_start = newline + 1;
+            }
+            parse_error->column = (line_start != NULL) ? ((size_t)((local_error.json + local_error.position) - line_start) + 1) : 0;
+        }
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(const char *) cJSON_GetParseErrorMessage(int reason)
+{
+    switch (reason)
+    {
+        case cJSON_ParseErrorNone:
+            return "no error";
+        case cJSON_ParseErrorNoInput:
+            return "no input";
+        case cJSON_ParseErrorOutOfMemory:
+            return "out of memory";
+        case cJSON_ParseErrorUnexpectedEnd:
+            return "unexpected end of input";
+        case cJSON_ParseErrorUnexpectedCharacter:
+            return "unexpected character";
+        case cJSON_ParseErrorInvalidString:
+            return "invalid escape sequence in string";
+        case cJSON_ParseErrorInvalidNumber:
+            return "invalid number";
+        case cJSON_ParseErrorTooDeep:
+            return "nested too deeply";
+        case cJSON_ParseErrorTrailingData:
+            return "data after the end of the document";
+        default:
+            return "unknown error";
+    }
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseArena(const char *value, size_t buffer_length, cJSON_Arena *arena)
+{
+    if (arena == NULL)
+    {
+        return NULL;
+    }
+
+    return parse_document(value, buffer_length, NULL, false, arena, NULL, &global_hooks, &global_error);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInPlace(char *value, size_t buffer_length)
+{
+    return parse_document(value, buffer_length, NULL, false, NULL, (unsigned char*)value, &global_hooks, &global_error);
+}
+
+/* Two stage parsing for large documents. Stage 1 classifies 64 bytes at a time into bit masks and
+ * records the position of every structural character ({}[]:,) and of the first byte of every string,
+ * number and literal, ignoring everything inside of strings. Stage 2 walks these positions to build the
+ * tree: tokens are decoded by parse_string and parse_value, but the whitespace between them is never
+ * read. Every token is still checked where it starts and ends, so the index only has to be right for a
+ * valid document; anything the walk doesn't accept is parsed again by parse_document for the error.
+ * The index is built for a small window of the input at a time, it lives on the stack and in the cache.
+ * (A large allocation here would also make malloc consolidate its free lists, which slows down every
+ * allocation of the tree that follows.) */
+#define STRUCTURAL_WINDOW_SIZE 1024
+
+typedef struct
+{
+    const unsigned char *input;
+    size_t length;
+    size_t offset; /* first byte that isn't indexed yet */
+    cjson_uint64 escape_carry; /* 1 if the last indexed block ended in an unescaped backslash */
+    cjson_uint64 in_string_carry; /* all ones if the last indexed block ended inside of a string */
+    cjson_uint64 scalar_carry; /* 1 if the last indexed block ended in a number or literal */
+    size_t window; /* offset of the indexed window */
+    size_t count;
+    size_t current;
+    unsigned short positions[STRUCTURAL_WINDOW_SIZE]; /* relative to window */
+} structural_index;
+
+/* bytes of a 64 byte block, bit i is byte i */
+typedef struct
+{
+    cjson_uint64 quote;
+    cjson_uint64 backslash;
+    cjson_uint64 whitespace;
+    cjson_uint64 operators;
+} block_masks;
+
+static unsigned int lowest_bit(cjson_uint64 mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int)__builtin_ctzll(mask);
+#elif defined(CJSON_SIMD_SSE2) && defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+    unsigned long index = 0;
+    _BitScanForward64(&index, mask);
+    return (unsigned int)index;
+#else
+    unsigned int index = 0;
+    while ((mask & 1) == 0)
+    {
+        mask >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+static void classify_block(const unsigned char * const block, block_masks * const masks)
+{
+#if defined(CJSON_SIMD_SSE2)
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i open = _mm_set1_epi8('{'); /* '[' | 0x20 */
+    const __m128i close = _mm_set1_epi8('}'); /* ']' | 0x20 */
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    unsigned int i = 0;
+
+    memset(masks, '\0', sizeof(block_masks));
+    for (i = 0; i < 4; i++)
+    {
+        const __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(block + (i * 16)));
+        const __m128i folded = _mm_or_si128(chunk, lower);
+        const __m128i operators = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)), _mm_or_si128(_mm_cmpeq_epi8(chunk, colon), _mm_cmpeq_epi8(chunk, comma)));
+
+        masks->quote |= (cjson_uint64)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)) << (i * 16);
+        masks->backslash |= (cjson_uint64)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash)) << (i * 16);
+        masks->whitespace |= (cjson_uint64)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(chunk, space), chunk)) << (i * 16);
+        masks->operators |= (cjson_uint64)(unsigned int)_mm_movemask_epi8(operators) << (i * 16);
+    }
+#else
+    unsigned int i = 0;
+
+    memset(masks, '\0', sizeof(block_masks));
+    for (i = 0; i < 64; i++)
+    {
+        const cjson_uint64 bit = CJSON_UINT64_C(1) << i;
+        switch (block[i])
+        {
+            case '\"':
+                masks->quote |= bit;
+                break;
+            case '\\':
+                masks->backslash |= bit;
+                break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':
+                masks->operators |= bit;
+                break;
+            default:
+                if (block[i] <= 32)
+                {
+                    masks->whitespace |= bit;
+                }
+                break;
+        }
+    }
+#endif
+}
+
+/* bytes that follow an unescaped backslash, escape_carry is 1 if the previous block ended in one */
+static cjson_uint64 find_escaped(cjson_uint64 backslash, cjson_uint64 * const escape_carry)
+{
+    cjson_uint64 escaped = *escape_carry;
+
+    /* backslashes are rare, so go through them one by one */
+    *escape_carry = 0;
+    while (backslash != 0)
+    {
+        const unsigned int index = lowest_bit(backslash);
+        backslash &= backslash - 1;
+        if ((escaped >> index) & 1)
+        {
+            continue;
+        }
+        if (index == 63)
+        {
+            *escape_carry = 1;
+        }
+        else
+        {
+            escaped |= CJSON_UINT64_C(1) << (index + 1);
+        }
+    }
+
+    return escaped;
+}
+
+/* bit i is the xor of the bits 0 to i */
+static cjson_uint64 prefix_xor(cjson_uint64 mask)
+{
+    mask ^= mask << 1;
+    mask ^= mask << 2;
+    mask ^= mask << 4;
+    mask ^= mask << 8;
+    mask ^= mask << 16;
+    mask ^= mask << 32;
+
+    return mask;
+}
+
+/* index the next window of the input */
+static void index_window(structural_index * const index)
+{
+    const size_t window_end = ((index->length - index->offset) > STRUCTURAL_WINDOW_SIZE) ? (index->offset + STRUCTURAL_WINDOW_SIZE) : index->length;
+
+    index->window = index->offset;
+    index->count = 0;
+    index->current = 0;
+    for (; index->offset < window_end; index->offset += 64)
+    {
+        unsigned char padded[64];
+        const unsigned char *block = index->input + index->offset;
+        block_masks masks;
+        cjson_uint64 quotes = 0;
+        cjson_uint64 in_string = 0;
+        cjson_uint64 scalars = 0;
+        cjson_uint64 continued = 0;
+        cjson_uint64 structurals = 0;
+
+        if ((index->length - index->offset) < 64)
+        {
+            /* pad the last block with whitespace */
+            memset(padded, ' ', sizeof(padded));
+            memcpy(padded, block, index->length - index->offset);
+            block = padded;
+        }
+        classify_block(block, &masks);
+
+        quotes = masks.quote & ~find_escaped(masks.backslash, &index->escape_carry);
+        /* from an opening quote up to, but without, the closing quote */
+        in_string = prefix_xor(quotes) ^ index->in_string_carry;
+        index->in_string_carry = CJSON_UINT64_C(0) - (in_string >> 63);
+
+        /* numbers and literals start after whitespace, an operator or a quote */
+        scalars = ~(masks.operators | masks.whitespace);
+        continued = ((scalars & ~quotes) << 1) | index->scalar_carry;
+        index->scalar_carry = ((scalars & ~quotes) >> 63);
+
+        /* drop everything behind the opening quote of a string */
+        structurals = (masks.operators | (scalars & ~continued)) & ~(in_string ^ quotes);
+
+        while (structurals != 0)
+        {
+            index->positions[index->count++] = (unsigned short)((index->offset - index->window) + lowest_bit(structurals));
+            structurals &= structurals - 1;
+        }
+    }
+}
+
+/* position of the next token without consuming it, the length of the input if there is none */
+static size_t peek_structural(structural_index * const index)
+{
+    if (index->current < index->count)
+    {
+        return index->window + index->positions[index->current];
+    }
+
+    while ((index->current == index->count) && (index->offset < index->length))
+    {
+        index_window(index);
+    }
+
+    return (index->current < index->count) ? (index->window + index->positions[index->current]) : index->length;
+}
+
+static size_t next_structural(structural_index * const index)
+{
+    const size_t position = peek_structural(index);
+
+    if (index->current < index->count)
+    {
+        index->current++;
+    }
+
+    return position;
+}
+
+typedef struct
+{
+    cJSON *container;
+    cJSON *last; /* last child */
+} indexed_frame;
+
+/* build the tree from the index, NULL if the document isn't valid or memory runs out */
+static cJSON *parse_indexed(parse_buffer * const buffer, structural_index * const index)
+{
+    const unsigned char * const content = buffer->content;
+    indexed_frame *stack = NULL;
+    size_t depth = 0;
+    size_t capacity = 0;
+    cJSON *root = NULL;
+
+    for (;;)
+    {
+        cJSON *item = parse_new_item(buffer);
+        size_t position = 0;
+
+        if (item == NULL)
+        {
+            goto fail; /* allocation failure */
+        }
+
+        /* link the value into the open container */
+        if (depth == 0)
+        {
+            root = item;
+        }
+        else
+        {
+            indexed_frame * const frame = &stack[depth - 1];
+            if (frame->last == NULL)
+            {
+                frame->container->child = item;
+            }
+            else
+            {
+                frame->last->next = item;
+                item->prev = frame->last;
+            }
+            frame->last = item;
+
+            if (frame->container->type == cJSON_Object)
+            {
+                /* parse the name of the member */
+                position = next_structural(index);
+                if ((position >= buffer->length) || (content[position] != '\"'))
+                {
+                    goto fail;
+                }
+                buffer->offset = position;
+                if (!parse_string(item, buffer))
+                {
+                    goto fail;
+                }
+                item->string = item->valuestring;
+                item->valuestring = NULL;
+
+                position = next_structural(index);
+                if ((position >= buffer->length) || (content[position] != ':'))
+                {
+                    goto fail;
+                }
+            }
+        }
+
+        position = next_structural(index);
+        if (position >= buffer->length)
+        {
+            goto fail;
+        }
+
+        if ((content[position] == '[') || (content[position] == '{'))
+        {
+            const unsigned char end = (content[position] == '[') ? ']' : '}';
+
+            if (depth >= CJSON_NESTING_LIMIT)
+            {
+                goto fail; /* to deeply nested */
+            }
+            if (depth == capacity)
+            {
+                indexed_frame *new_stack = NULL;
+                capacity = (capacity > 0) ? (capacity * 2) : 32;
+
+                new_stack = (indexed_frame*)global_hooks.allocate(global_hooks.user_data, capacity * sizeof(indexed_frame));
+                if (new_stack == NULL)
+                {
+                    goto fail;
+                }
+                if (stack != NULL)
+                {
+                    memcpy(new_stack, stack, depth * sizeof(indexed_frame));
+                    global_hooks.deallocate(global_hooks.user_data, stack);
+                }
+                stack = new_stack;
+            }
+            item->type = (end == ']') ? cJSON_Array : cJSON_Object;
+            stack[depth].container = item;
+            stack[depth].last = NULL;
+            depth++;
+
+            position = peek_structural(index);
+            if ((position >= buffer->length) || (content[position] != end))
+            {
+                continue; /* the first element */
+            }
+
+            /* empty container */
+            next_structural(index);
+            depth--;
+            buffer->offset = position + 1;
+        }
+        else
+        {
+            size_t next = 0;
+
+            /* the first byte decides the type, parse_value would try the literals first */
+            buffer->offset = position;
+            switch (content[position])
+            {
+                case '\"':
+                    if (!parse_string(item, buffer))
+                    {
+                        goto fail;
+                    }
+                    break;
+
+                case 'n':
+                case 't':
+                case 'f':
+                    if (!parse_value(item, buffer))
+                    {
+                        goto fail;
+                    }
+                    break;
+
+                default:
+                    if (((content[position] != '-') && ((content[position] < '0') || (content[position] > '9'))) || !parse_number(item, buffer))
+                    {
+                        goto fail;
+                    }
+                    break;
+            }
+
+            /* a number or literal has to end at the next token or in whitespace, which then reaches
+             * up to the next token. Strings always do, their end was found in the same way as in stage 1. */
+            next = peek_structural(index);
+            if ((depth > 0) && (content[position] != '\"') && (buffer->offset != next))
+            {
+                if ((buffer->offset > next) || (buffer->offset >= buffer->length) || (content[buffer->offset] > 32))
+                {
+                    goto fail;
+                }
+            }
+        }
+
+        /* a ',' continues the container, closing brackets end it and maybe the enclosing ones */
+        while (depth > 0)
+        {
+            indexed_frame * const frame = &stack[depth - 1];
+
+            position = next_structural(index);
+            if (position >= buffer->length)
+            {
+                goto fail;
+            }
+            if (content[position] == ',')
+            {
+                break;
+            }
+            if (content[position] != ((frame->container->type == cJSON_Array) ? ']' : '}'))
+            {
+                goto fail;
+            }
+
+            if (frame->container->child != NULL)
+            {
+                frame->container->child->prev = frame->last;
+            }
+            depth--;
+            buffer->offset = position + 1;
+        }
+
+        if (depth == 0)
+        {
+            break;
+        }
+    }
+
+    if (stack != NULL)
+    {
+        global_hooks.deallocate(global_hooks.user_data, stack);
+    }
+
+    return root;
+
+fail:
+    if (stack != NULL)
+    {
+        global_hooks.deallocate(global_hooks.user_data, stack);
+    }
+    if (root != NULL)
+    {
+        cJSON_Delete(root);
+    }
+
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseFast(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0, NULL }, NULL, NULL, 0 };
+    structural_index index;
+    cJSON *item = NULL;
+
+    if ((value == NULL) || (buffer_length == 0))
+    {
+        return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
+    }
+
+    buffer.content = (const unsigned char*)value;
+    buffer.length = buffer_length;
+    buffer.offset = 0;
+    buffer.hooks = global_hooks;
+    skip_utf8_bom(&buffer);
+
+    memset(&index, '\0', sizeof(index));
+    index.input = buffer.content;
+    index.length = buffer.length;
+    index.offset = buffer.offset;
+    item = parse_indexed(&buffer, &index);
+
+    if (item != NULL)
+    {
+        /* same checks as parse_document after the value */
+        if (require_null_terminated)
+        {
+            buffer_skip_whitespace(&buffer);
+            if ((buffer.offset >= buffer.length) || buffer_at_offset(&buffer)[0] != '\0')
+            {
+                cJSON_Delete(item);
+                item = NULL;
+            }
+        }
+    }
+    if (item == NULL)
+    {
+        /* invalid, let the reference parser find the error */
+        return cJSON_ParseWithLengthOpts(value, buffer_length, return_parse_end, require_null_terminated);
+    }
+
+    global_error.json = NULL;
+    global_error.position = 0;
+    global_error.reason = cJSON_ParseErrorNone;
+    if (return_parse_end)
+    {
+        *return_parse_end = (const char*)buffer_at_offset(&buffer);
+    }
+
+    return item;
+}
+
+/* Default options for cJSON_Parse */
+CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
+{
+    return cJSON_ParseWithOpts(value, 0, 0);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_length)
+{
+    return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
+}
+
+/* Records of a batch are parsed into this, on worker threads. */
+typedef struct
+{
+    const char *json; /* start of the record */
+    size_t length;
+    cJSON *item; /* NULL for a blank line or an invalid record */
+    error parse_error; /* json is NULL unless the record is invalid */
+} line_record;
+
+typedef struct
+{
+    line_record *records;
+    size_t count;
+    internal_hooks hooks; /* the global hooks, with a slab of the shard if the global one is enabled */
+    cJSON_Slab slab;
+} line_shard;
+
+/* batches are handed to the workers once they hold this many bytes */
+#define LINES_BATCH_SIZE (4u * 1024u * 1024u)
+/* shards smaller than this aren't worth a thread */
+#define LINES_MIN_SHARD_SIZE (64u * 1024u)
+#define LINES_MAX_THREADS 64
+
+#if defined(CJSON_THREADS_WIN32) || defined(CJSON_THREADS_PTHREAD)
+#define CJSON_THREADS
+#endif
+
+typedef struct line_pool line_pool;
+
+#if defined(CJSON_THREADS)
+typedef struct
+{
+    line_pool *pool;
+    size_t shard; /* the one this worker parses in every batch */
+#if defined(CJSON_THREADS_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+} line_thread;
+#endif
+
+/* Shards of the current batch and the workers of one cJSON_ParseLines call. The workers are started once
+ * and parse one shard of every batch, shard 0 is parsed on the calling thread. */
+struct line_pool
+{
+    line_shard shards[LINES_MAX_THREADS];
+    size_t shard_count; /* one more than the number of workers */
+#if defined(CJSON_THREADS)
+    line_thread threads[LINES_MAX_THREADS - 1];
+    cJSON_bool synchronized; /* the lock and conditions below were created */
+    size_t batch; /* number of batches handed out */
+    size_t pending; /* workers that are still parsing the current batch */
+    cJSON_bool stop;
+#if defined(CJSON_THREADS_WIN32)
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE start;
+    CONDITION_VARIABLE done;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+#endif
+#endif
+};
+
+#if defined(CJSON_THREADS_WIN32)
+#define pool_lock(pool) EnterCriticalSection(&(pool)->lock)
+#define pool_unlock(pool) LeaveCriticalSection(&(pool)->lock)
+#define pool_wait(pool, condition) SleepConditionVariableCS(&(pool)->condition, &(pool)->lock, INFINITE)
+#define pool_wake_all(pool, condition) WakeAllConditionVariable(&(pool)->condition)
+#elif defined(CJSON_THREADS_PTHREAD)
+#define pool_lock(pool) pthread_mutex_lock(&(pool)->lock)
+#define pool_unlock(pool) pthread_mutex_unlock(&(pool)->lock)
+#define pool_wait(pool, condition) pthread_cond_wait(&(pool)->condition, &(pool)->lock)
+#define pool_wake_all(pool, condition) pthread_cond_broadcast(&(pool)->condition)
+#endif
+
+/* end of the record that starts at offset, the next newline outside of a string */
+static size_t find_line_end(const unsigned char * const input, const size_t length, size_t offset)
+{
+    while (offset < length)
+    {
+        offset += scan_line_special(input + offset, length - offset);
+        if ((offset >= length) || (input[offset] == '\n'))
+        {
+            break;
+        }
+
+        /* skip the string */
+        offset++;
+        while (offset < length)
+        {
+            offset += scan_string_special(input + offset, length - offset);
+            if ((offset >= length) || (input[offset] == '\"'))
+            {
+                offset++;
+                break;
+            }
+            /* backslash, skip the escaped character */
+            offset += 2;
+        }
+    }
+
+    return (offset < length) ? offset : length;
+}
+
+static void parse_line_shard(line_shard * const shard)
+{
+    size_t i = 0;
+
+    for (i = 0; i < shard->count; i++)
+    {
+        line_record * const record = &shard->records[i];
+        const char *end = NULL;
+        size_t position = 0;
+
+        record->item = NULL;
+        record->parse_error.json = NULL;
+        record->parse_error.position = 0;
+        record->parse_error.reason = cJSON_ParseErrorNone;
+
+        if (scan_whitespace((const unsigned char*)record->json, record->length) == record->length)
+        {
+            /* blank line */
+            continue;
+        }
+
+        record->item = parse_document(record->json, record->length, &end, false, NULL, NULL, &shard->hooks, &record->parse_error);
+        if (record->item == NULL)
+        {
+            continue;
+        }
+
+        /* one value per line, only whitespace may follow it */
+        position = (size_t)(end - record->json);
+        position += scan_whitespace((const unsigned char*)end, record->length - position);
+        if (position != record->length)
+        {
+            delete_item(record->item, &shard->hooks);
+            record->item = NULL;
+            record->parse_error.json = (const unsigned char*)record->json;
+            record->parse_error.position = position;
+            record->parse_error.reason = cJSON_ParseErrorTrailingData;
+        }
+    }
+}
+
+#if defined(CJSON_THREADS)
+static void run_line_thread(const line_thread * const thread)
+{
+    line_pool * const pool = thread->pool;
+    size_t batch = 0;
+
+    pool_lock(pool);
+    for (;;)
+    {
+        while ((pool->batch == batch) && !pool->stop)
+        {
+            pool_wait(pool, start);
+        }
+        if (pool->stop)
+        {
+            break;
+        }
+        batch = pool->batch;
+        pool_unlock(pool);
+
+        parse_line_shard(&pool->shards[thread->shard]);
+
+        pool_lock(pool);
+        pool->pending--;
+        if (pool->pending == 0)
+        {
+            pool_wake_all(pool, done);
+        }
+    }
+    pool_unlock(pool);
+}
+
+#if defined(CJSON_THREADS_WIN32)
+static unsigned __stdcall line_thread_main(void *thread)
+{
+    run_line_thread((const line_thread*)thread);
+
+    return 0;
+}
+#else
+static void *line_thread_main(void *thread)
+{
+    run_line_thread((const line_thread*)thread);
+
+    return NULL;
+}
+#endif
+#endif
+
+static int default_line_threads(void)
+{
+#if defined(CJSON_THREADS_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#elif defined(CJSON_THREADS_PTHREAD) && defined(_SC_NPROCESSORS_ONLN)
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return (processors > 0) ? (int)processors : 1;
+#else
+    return 1;
+#endif
+}
+
+/* starts threads - 1 workers, or as many as the system gives us */
+static void line_pool_start(line_pool * const pool, const size_t threads)
+{
+    pool->shard_count = 1;
+#if defined(CJSON_THREADS)
+    pool->synchronized = false;
+    pool->batch = 0;
+    pool->pending = 0;
+    pool->stop = false;
+    if (threads < 2)
+    {
+        return;
+    }
+
+#if defined(CJSON_THREADS_WIN32)
+    InitializeCriticalSection(&pool->lock);
+    InitializeConditionVariable(&pool->start);
+    InitializeConditionVariable(&pool->done);
+#else
+    if (pthread_mutex_init(&pool->lock, NULL) != 0)
+    {
+        return;
+    }
+    if (pthread_cond_init(&pool->start, NULL) != 0)
+    {
+        pthread_mutex_destroy(&pool->lock);
+        return;
+    }
+    if (pthread_cond_init(&pool->done, NULL) != 0)
+    {
+        pthread_cond_destroy(&pool->start);
+        pthread_mutex_destroy(&pool->lock);
+        return;
+    }
+#endif
+    pool->synchronized = true;
+
+    while (pool->shard_count < threads)
+    {
+        line_thread * const thread = &pool->threads[pool->shard_count - 1];
+
+        thread->pool = pool;
+        thread->shard = pool->shard_count;
+#if defined(CJSON_THREADS_WIN32)
+        thread->handle = (HANDLE)_beginthreadex(NULL, 0, line_thread_main, thread, 0, NULL);
+        if (thread->handle == 0)
+        {
+            break;
+        }
+#else
+        if (pthread_create(&thread->handle, NULL, line_thread_main, thread) != 0)
+        {
+            break;
+        }
+#endif
+        pool->shard_count++;
+    }
+#else
+    (void)threads;
+#endif
+}
+
+static void line_pool_stop(line_pool * const pool)
+{
+#if defined(CJSON_THREADS)
+    size_t i = 0;
+
+    if (!pool->synchronized)
+    {
+        return;
+    }
+
+    pool_lock(pool);
+    pool->stop = true;
+    pool_wake_all(pool, start);
+    pool_unlock(pool);
+
+    for (i = 0; (i + 1) < pool->shard_count; i++)
+    {
+#if defined(CJSON_THREADS_WIN32)
+        WaitForSingleObject(pool->threads[i].handle, INFINITE);
+        CloseHandle(pool->threads[i].handle);
+#else
+        pthread_join(pool->threads[i].handle, NULL);
+#endif
+    }
+
+#if defined(CJSON_THREADS_WIN32)
+    DeleteCriticalSection(&pool->lock);
+#else
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+#endif
+#else
+    (void)pool;
+#endif
+}
+
+/* parse the records of a batch, the first shard on the calling thread and the others on the workers */
+static void parse_line_batch(line_pool * const pool, line_record * const records, const size_t count, const size_t bytes)
+{
+    size_t shard_count = pool->shard_count;
+    size_t first = 0;
+    size_t i = 0;
+
+    if (shard_count > (bytes / LINES_MIN_SHARD_SIZE))
+    {
+        shard_count = bytes / LINES_MIN_SHARD_SIZE;
+    }
+    if (shard_count < 1)
+    {
+        shard_count = 1;
+    }
+
+    /* contiguous shards with about the same number of bytes, workers beyond shard_count get none */
+    for (i = 0; i < pool->shard_count; i++)
+    {
+        line_shard * const shard = &pool->shards[i];
+        const size_t target = (bytes / shard_count) * (i + 1);
+        size_t last = first;
+        size_t shard_bytes = (first < count) ? (size_t)(records[first].json - records[0].json) : bytes;
+
+        while ((i < shard_count) && (last < count) && ((shard_bytes < target) || (i == (shard_count - 1))))
+        {
+            shard_bytes += records[last].length + 1;
+            last++;
+        }
+        shard->records = records + first;
+        shard->count = last - first;
+        shard->hooks = global_hooks;
+        memset(&shard->slab, '\0', sizeof(cJSON_Slab));
+        if (global_hooks.slab != NULL)
+        {
+            /* the global slab isn't thread safe, so each shard fills its own */
+            shard->slab.nodes_per_page = global_slab.nodes_per_page;
+            shard->hooks.slab = &shard->slab;
+        }
+        first = last;
+    }
+
+#if defined(CJSON_THREADS)
+    if (pool->shard_count > 1)
+    {
+        pool_lock(pool);
+        pool->pending = pool->shard_count - 1;
+        pool->batch++;
+        pool_wake_all(pool, start);
+        pool_unlock(pool);
+
+        parse_line_shard(&pool->shards[0]);
+
+        pool_lock(pool);
+        while (pool->pending != 0)
+        {
+            pool_wait(pool, done);
+        }
+        pool_unlock(pool);
+    }
+    else
+#endif
+    {
+        parse_line_shard(&pool->shards[0]);
+    }
+
+    if (global_hooks.slab != NULL)
+    {
+        for (i = 0; i < pool->shard_count; i++)
+        {
+            line_shard * const shard = &pool->shards[i];
+            size_t j = 0;
+
+            if (slab_merge(&global_slab, &shard->slab, &global_hooks))
+            {
+                continue;
+            }
+
+            /* the nodes of this shard couldn't be handed over, so its records fail */
+            for (j = 0; j < shard->count; j++)
+            {
+                line_record * const record = &shard->records[j];
+                if (record->item != NULL)
+                {
+                    delete_item(record->item, &shard->hooks);
+                    record->item = NULL;
+                }
+                record->parse_error.json = (const unsigned char*)record->json;
+                record->parse_error.position = 0;
+                record->parse_error.reason = cJSON_ParseErrorOutOfMemory;
+            }
+            slab_release(&shard->slab, &global_hooks);
+        }
+    }
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_ParseLines(const char *value, size_t buffer_length, int threads, cJSON_bool (*callback)(void *user_data, cJSON *item), void *user_data)
+{
+    const unsigned char * const input = (const unsigned char*)value;
+    line_record *records = NULL;
+    size_t capacity = 0;
+    size_t offset = 0;
+    size_t thread_count = 0;
+    line_pool pool;
+    cJSON_bool result = true;
+
+    /* reset error position */
+    global_error.json = NULL;
+    global_error.position = 0;
+    global_error.reason = cJSON_ParseErrorNone;
+
+    if ((value == NULL) || (callback == NULL))
+    {
+        return false;
+    }
+
+    if (threads <= 0)
+    {
+        threads = default_line_threads();
+    }
+    thread_count = (threads > LINES_MAX_THREADS) ? LINES_MAX_THREADS : (size_t)threads;
+    /* no more workers than the input has shards for */
+    if (thread_count > (buffer_length / LINES_MIN_SHARD_SIZE))
+    {
+        thread_count = buffer_length / LINES_MIN_SHARD_SIZE;
+    }
+    line_pool_start(&pool, thread_count);
+
+    while (result && (offset < buffer_length))
+    {
+        const size_t batch_start = offset;
+        size_t count = 0;
+        size_t i = 0;
+
+        /* split the next batch into records */
+        while ((offset < buffer_length) && ((offset - batch_start) < LINES_BATCH_SIZE))
+        {
+            const size_t end = find_line_end(input, buffer_length, offset);
+
+            if (count == capacity)
+            {
+                line_record *new_records = NULL;
+                size_t new_capacity = (capacity > 0) ? (capacity * 2) : 256;
+
+                new_records = (line_record*)global_hooks.allocate(global_hooks.user_data, new_capacity * sizeof(line_record));
+                if (new_records == NULL)
+                {
+                    result = false;
+                    break;
+                }
+                if (records != NULL)
+                {
+                    memcpy(new_records, records, count * sizeof(line_record));
+                    global_hooks.deallocate(global_hooks.user_data, records);
+                }
+                records = new_records;
+                capacity = new_capacity;
+            }
+            records[count].json = value + offset;
+            records[count].length = end - offset;
+            count++;
+            offset = end + 1;
+        }
+        if (!result)
+        {
+            break;
+        }
+
+        parse_line_batch(&pool, records, count, offset - batch_start);
+
+        /* hand out the results in order */
+        for (i = 0; i < count; i++)
+        {
+            if (!result)
+            {
+                cJSON_Delete(records[i].item);
+            }
+            else if (records[i].parse_error.json != NULL)
+            {
+                global_error = records[i].parse_error;
+                result = false;
+            }
+            else if ((records[i].item != NULL) && !callback(user_data, records[i].item))
+            {
+                result = false;
+            }
+        }
+    }
+
+    line_pool_stop(&pool);
+    if (records != NULL)
+    {
+        global_hooks.deallocate(global_hooks.user_data, records);
+    }
+
+    return result;
+}
+
+static cJSON_bool add_line_to_array(void *array, cJSON *item)
+{
+    if (!cJSON_AddItemToArray((cJSON*)array, item))
+    {
+        cJSON_Delete(item);
+        return false;
+    }
+
+    return true;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseLinesToArray(const char *value, size_t buffer_length, int threads)
+{
+    cJSON *array = cJSON_CreateArray();
+    if (array == NULL)
+    {
+        return NULL;
+    }
+
+    if (!cJSON_ParseLines(value, buffer_length, threads, add_line_to_array, array))
+    {
+        cJSON_Delete(array);
+        return NULL;
+    }
+
+    return array;
+}
+
+/* Event parsing mirrors parse_value, parse_array and parse_object step for step, so it accepts the same
+ * documents and fails at the same offsets. Strings and numbers go through parse_string and parse_number
+ * with a scratch item, the strings are decoded into the arena of the parse buffer. */
+typedef struct
+{
+    const cJSON_SaxHandler *handler;
+    void *user_data;
+    cJSON_bool keep_strings; /* otherwise the arena is reset after each string callback */
+} sax_context;
+
+static cJSON_bool sax_parse_value(const sax_context * const sax, parse_buffer * const input_buffer);
+
+static cJSON_bool sax_parse_string(const sax_context * const sax, parse_buffer * const input_buffer, const cJSON_bool is_key)
+{
+    cJSON scratch;
+    cJSON_bool (*callback)(void *user_data, const char *value) = NULL;
+    cJSON_bool result = true;
+
+    memset(&scratch, '\0', sizeof(scratch));
+    if (!parse_string(&scratch, input_buffer))
+    {
+        return false;
+    }
+
+    callback = is_key ? sax->handler->key : sax->handler->string;
+    if (callback != NULL)
+    {
+        result = callback(sax->user_data, scratch.valuestring);
+    }
+    if (!sax->keep_strings)
+    {
+        cJSON_ArenaReset(input_buffer->arena);
+    }
+
+    return result;
+}
+
+static cJSON_bool sax_parse_array(const sax_context * const sax, parse_buffer * const input_buffer)
+{
+    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    {
+        parse_fail(input_buffer, cJSON_ParseErrorTooDeep);
+        return false; /* to deeply nested */
+    }
+    input_buffer->depth++;
+
+    if ((sax->handler->start_array != NULL) && !sax->handler->start_array(sax->user_data))
+    {
+        return false;
+    }
+
+    input_buffer->offset++;
+    buffer_skip_whitespace(input_buffer);
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ']'))
+    {
+        /* empty array */
+        goto success;
+    }
+
+    /* check if we skipped to the end of the buffer */
+    if (cannot_access_at_index(input_buffer, 0))
+    {
+        input_buffer->offset--;
+        return false;
+    }
+
+    /* step back to character in front of the first element */
+    input_buffer->offset--;
+    /* loop through the comma separated array elements */
+    do
+    {
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if (!sax_parse_value(sax, input_buffer))
+        {
+            return false; /* failed to parse value */
+        }
+        buffer_skip_whitespace(input_buffer);
+    }
+    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
+
+    if (cannot_access_at_index(input_buffer, 0) || buffer_at_offset(input_buffer)[0] != ']')
+    {
+        return false; /* expected end of array */
+    }
+
+success:
+    input_buffer->depth--;
+    input_buffer->offset++;
+
+    return (sax->handler->end_array == NULL) || sax->handler->end_array(sax->user_data);
+}
+
+static cJSON_bool sax_parse_object(const sax_context * const sax, parse_buffer * const input_buffer)
+{
+    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    {
+        parse_fail(input_buffer, cJSON_ParseErrorTooDeep);
+        return false; /* to deeply nested */
+    }
+    input_buffer->depth++;
+
+    if ((sax->handler->start_object != NULL) && !sax->handler->start_object(sax->user_data))
+    {
+        return false;
+    }
+
+    input_buffer->offset++;
+    buffer_skip_whitespace(input_buffer);
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '}'))
+    {
+        goto success; /* empty object */
+    }
+
+    /* check if we skipped to the end of the buffer */
+    if (cannot_access_at_index(input_buffer, 0))
+    {
+        input_buffer->offset--;
+        return false;
+    }
+
+    /* step back to character in front of the first element */
+    input_buffer->offset--;
+    /* loop through the comma separated array elements */
+    do
+    {
+        if (cannot_access_at_index(input_buffer, 1))
+        {
+            return false; /* nothing comes after the comma */
+        }
+
+        /* parse the name of the child */
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if (!sax_parse_string(sax, input_buffer, true))
+        {
+            return false; /* failed to parse name */
+        }
+        buffer_skip_whitespace(input_buffer);
+
+        if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
+        {
+            return false; /* invalid object */
+        }
+
+        /* parse the value */
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if (!sax_parse_value(sax, input_buffer))
+        {
+            return false; /* failed to parse value */
+        }
+        buffer_skip_whitespace(input_buffer);
+    }
+    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
+
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '}'))
+    {
+        return false; /* expected end of object */
+    }
+
+success:
+    input_buffer->depth--;
+    input_buffer->offset++;
+
+    return (sax->handler->end_object == NULL) || sax->handler->end_object(sax->user_data);
+}
+
+static cJSON_bool sax_parse_value(const sax_context * const sax, parse_buffer * const input_buffer)
+{
+    const cJSON_SaxHandler * const handler = sax->handler;
+
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    {
+        return false; /* no input */
+    }
+
+    /* null */
+    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "null", 4) == 0))
+    {
+        input_buffer->offset += 4;
+        return (handler->null_value == NULL) || handler->null_value(sax->user_data);
+    }
+    /* false */
+    if (can_read(input_buffer, 5) && (strncmp((const char*)buffer_at_offset(input_buffer), "false", 5) == 0))
+    {
+        input_buffer->offset += 5;
+        return (handler->boolean == NULL) || handler->boolean(sax->user_data, false);
+    }
+    /* true */
+    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "true", 4) == 0))
+    {
+        input_buffer->offset += 4;
+        return (handler->boolean == NULL) || handler->boolean(sax->user_data, true);
+    }
+    /* string */
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '\"'))
+    {
+        return sax_parse_string(sax, input_buffer, false);
+    }
+    /* number */
+    if (can_access_at_index(input_buffer, 0) && ((buffer_at_offset(input_buffer)[0] == '-') || ((buffer_at_offset(input_buffer)[0] >= '0') && (buffer_at_offset(input_buffer)[0] <= '9'))))
+    {
+        cJSON scratch;
+
+        memset(&scratch, '\0', sizeof(scratch));
+        if (!parse_number(&scratch, input_buffer))
+        {
+            return false;
+        }
+
+        return (handler->number == NULL) || handler->number(sax->user_data, scratch.valuedouble);
+    }
+    /* array */
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '['))
+    {
+        return sax_parse_array(sax, input_buffer);
+    }
+    /* object */
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '{'))
+    {
+        return sax_parse_object(sax, input_buffer);
+    }
+
+    return false;
+}
+
+/* runs the handler over a document, strings are decoded into the given arena */
+static cJSON_bool sax_parse_document(const char * const value, const size_t buffer_length, const sax_context * const sax, cJSON_Arena * const strings)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0, NULL }, NULL, NULL, 0 };
+
+    /* reset error position */
+    global_error.json = NULL;
+    global_error.position = 0;
+    global_error.reason = cJSON_ParseErrorNone;
+
+    if (value == NULL || 0 == buffer_length || sax->handler == NULL)
+    {
+        goto fail;
+    }
+
+    buffer.content = (const unsigned char*)value;
+    buffer.length = buffer_length;
+    buffer.offset = 0;
+    buffer.hooks = global_hooks;
+    buffer.arena = strings;
+
+    if (!sax_parse_value(sax, buffer_skip_whitespace(skip_utf8_bom(&buffer))))
+    {
+        goto fail;
+    }
+
+    return true;
+
+fail:
+    if (value != NULL)
+    {
+        set_parse_error(value, &buffer, NULL, &global_error);
+    }
+
+    return false;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_ParseSax(const char *value, size_t buffer_length, const cJSON_SaxHandler *handler, void *user_data)
+{
+    sax_context sax;
+    cJSON_Arena strings;
+    cJSON_bool result = false;
+
+    sax.handler = handler;
+    sax.user_data = user_data;
+    sax.keep_strings = false;
+
+    /* the first block is reused for every string that fits in it */
+    cJSON_ArenaInit(&strings, 0);
+    result = sax_parse_document(value, buffer_length, &sax, &strings);
+    cJSON_ArenaFree(&strings);
+
+    return result;
+}
+
+/* The tape is built by a set of event handlers. While a container is open, its entry holds the
+ * position of the enclosing open container in value.count and its number of children in size. */
+typedef struct
+{
+    cJSON_Tape *tape;
+    size_t open; /* position of the innermost open container + 1, 0 if there is none */
+} tape_builder;
+
+/* append an entry, returns it or NULL if out of memory */
+static cJSON_TapeEntry *tape_append(tape_builder * const builder, const int type)
+{
+    cJSON_Tape * const tape = builder->tape;
+    cJSON_TapeEntry *entry = NULL;
+
+    if (tape->length == tape->capacity)
+    {
+        cJSON_TapeEntry *entries = NULL;
+        size_t capacity = (tape->capacity > 0) ? (tape->capacity * 2) : 64;
+
+        if ((capacity > (size_t)UINT_MAX) || (capacity > ((size_t)-1 / sizeof(cJSON_TapeEntry))))
+        {
+            return NULL;
+        }
+        entries = (cJSON_TapeEntry*)global_hooks.allocate(global_hooks.user_data, capacity * sizeof(cJSON_TapeEntry));
+        if (entries == NULL)
+        {
+            return NULL;
+        }
+        if (tape->entries != NULL)
+        {
+            memcpy(entries, tape->entries, tape->length * sizeof(cJSON_TapeEntry));
+            global_hooks.deallocate(global_hooks.user_data, tape->entries);
+        }
+        tape->entries = entries;
+        tape->capacity = capacity;
+    }
+
+    if ((type != cJSON_TapeKey) && (builder->open != 0))
+    {
+        /* one more child of the open container */
+        tape->entries[builder->open - 1].size++;
+    }
+
+    entry = &tape->entries[tape->length++];
+    entry->type = type;
+    entry->size = 1;
+    entry->value.count = 0;
+
+    return entry;
+}
+
+static cJSON_bool tape_null(void *user_data)
+{
+    return tape_append((tape_builder*)user_data, cJSON_NULL) != NULL;
+}
+
+static cJSON_bool tape_boolean(void *user_data, cJSON_bool value)
+{
+    return tape_append((tape_builder*)user_data, value ? cJSON_True : cJSON_False) != NULL;
+}
+
+static cJSON_bool tape_number(void *user_data, double value)
+{
+    cJSON_TapeEntry * const entry = tape_append((tape_builder*)user_data, cJSON_Number);
+    if (entry == NULL)
+    {
+        return false;
+    }
+    entry->value.number = value;
+
+    return true;
+}
+
+static cJSON_bool tape_string_entry(void *user_data, const char *value, const int type)
+{
+    cJSON_TapeEntry * const entry = tape_append((tape_builder*)user_data, type);
+    if (entry == NULL)
+    {
+        return false;
+    }
+    /* the strings arena is kept, so the pointer stays valid */
+    entry->value.string = value;
+
+    return true;
+}
+
+static cJSON_bool tape_string(void *user_data, const char *value)
+{
+    return tape_string_entry(user_data, value, cJSON_String);
+}
+
+static cJSON_bool tape_key(void *user_data, const char *key)
+{
+    return tape_string_entry(user_data, key, cJSON_TapeKey);
+}
+
+static cJSON_bool tape_start(void *user_data, const int type)
+{
+    tape_builder * const builder = (tape_builder*)user_data;
+    cJSON_TapeEntry * const entry = tape_append(builder, type);
+    if (entry == NULL)
+    {
+        return false;
+    }
+
+    entry->size = 0;
+    entry->value.count = builder->open;
+    builder->open = builder->tape->length;
+
+    return true;
+}
+
+static cJSON_bool tape_end(void *user_data)
+{
+    tape_builder * const builder = (tape_builder*)user_data;
+    const size_t position = builder->open - 1;
+    cJSON_TapeEntry * const entry = &builder->tape->entries[position];
+
+    builder->open = entry->value.count;
+    entry->value.count = entry->size;
+    entry->size = (unsigned int)(builder->tape->length - position);
+
+    return true;
+}
+
+static cJSON_bool tape_start_array(void *user_data)
+{
+    return tape_start(user_data, cJSON_Array);
+}
+
+static cJSON_bool tape_start_object(void *user_data)
+{
+    return tape_start(user_data, cJSON_Object);
+}
+
+CJSON_PUBLIC(cJSON_Tape *) cJSON_ParseTape(const char *value, size_t buffer_length)
+{
+    static const cJSON_SaxHandler tape_handler = {
+        tape_null,
+        tape_boolean,
+        tape_number,
+        tape_string,
+        tape_key,
+        tape_start_object,
+        tape_end,
+        tape_start_array,
+        tape_end
+    };
+    tape_builder builder;
+    sax_context sax;
+
+    builder.tape = (cJSON_Tape*)global_hooks.allocate(global_hooks.user_data, sizeof(cJSON_Tape));
+    builder.open = 0;
+    if (builder.tape == NULL)
+    {
+        return NULL;
+    }
+    memset(builder.tape, '\0', sizeof(cJSON_Tape));
+    cJSON_ArenaInit(&builder.tape->strings, 0);
+
+    sax.handler = &tape_handler;
+    sax.user_data = &builder;
+    sax.keep_strings = true;
+
+    if (!sax_parse_document(value, buffer_length, &sax, &builder.tape->strings))
+    {
+        cJSON_DeleteTape(builder.tape);
+        return NULL;
+    }
+
+    return builder.tape;
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteTape(cJSON_Tape *tape)
+{
+    if (tape == NULL)
+    {
+        return;
+    }
+
+    if (tape->entries != NULL)
+    {
+        global_hooks.deallocate(global_hooks.user_data, tape->entries);
+    }
+    cJSON_ArenaFree(&tape->strings);
+    global_hooks.deallocate(global_hooks.user_data, tape);
+}
+
+CJSON_PUBLIC(int) cJSON_TapeGetArraySize(const cJSON_TapeEntry *array)
+{
+    if ((array == NULL) || !(array->type & (cJSON_Array | cJSON_Object)))
+    {
+        return 0;
+    }
+
+    return (int)array->value.count;
+}
+
+CJSON_PUBLIC(const cJSON_TapeEntry *) cJSON_TapeChild(const cJSON_TapeEntry *container)
+{
+    if ((container == NULL) || !(container->type & (cJSON_Array | cJSON_Object)) || (container->value.count == 0))
+    {
+        return NULL;
+    }
+
+    /* skip the key of the first member */
+    return (container->type == cJSON_Object) ? (container + 2) : (container + 1);
+}
+
+CJSON_PUBLIC(const cJSON_TapeEntry *) cJSON_TapeNext(const cJSON_TapeEntry *container, const cJSON_TapeEntry *element)
+{
+    const cJSON_TapeEntry *next = NULL;
+
+    if ((container == NULL) || (element == NULL))
+    {
+        return NULL;
+    }
+
+    next = element + element->size;
+    if (next >= (container + container->size))
+    {
+        return NULL;
+    }
+
+    return (container->type == cJSON_Object) ? (next + 1) : next;
+}
+
+CJSON_PUBLIC(const cJSON_TapeEntry *) cJSON_TapeGetArrayItem(const cJSON_TapeEntry *array, int index)
+{
+    const cJSON_TapeEntry *element = NULL;
+
+    if ((index < 0) || (array == NULL) || (array->type != cJSON_Array))
+    {
+        return NULL;
+    }
+
+    for (element = cJSON_TapeChild(array); (element != NULL) && (index > 0); index--)
+    {
+        element = cJSON_TapeNext(array, element);
+    }
+
+    return element;
+}
+
+static const cJSON_TapeEntry *tape_get_object_item(const cJSON_TapeEntry * const object, const char * const name, const cJSON_bool case_sensitive)
+{
+    const cJSON_TapeEntry *key = NULL;
+    const cJSON_TapeEntry *end = NULL;
+
+    if ((object == NULL) || (object->type != cJSON_Object) || (name == NULL))
+    {
+        return NULL;
+    }
+
+    end = object + object->size;
+    for (key = object + 1; key < end; key += 1 + key[1].size)
+    {
+        if (case_sensitive ? (strcmp(name, key->value.string) == 0) : (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)key->value.string) == 0))
+        {
+            return key + 1;
+        }
+    }
+
+    return NULL;
+}
+
+CJSON_PUBLIC(const cJSON_TapeEntry *) cJSON_TapeGetObjectItem(const cJSON_TapeEntry *object, const char *string)
+{
+    return tape_get_object_item(object, string, false);
+}
+
+CJSON_PUBLIC(const cJSON_TapeEntry *) cJSON_TapeGetObjectItemCaseSensitive(const cJSON_TapeEntry *object, const char *string)
+{
+    return tape_get_object_item(object, string, true);
+}
+
+CJSON_PUBLIC(const char *) cJSON_TapeGetKey(const cJSON_TapeEntry *object, const cJSON_TapeEntry *member)
+{
+    if ((object == NULL) || (object->type != cJSON_Object) || (member <= (object + 1)) || (member >= (object + object->size)))
+    {
+        return NULL;
+    }
+
+    /* every member value is preceded by its key, anything else is an element nested in a member */
+    if (member[-1].type != cJSON_TapeKey)
+    {
+        return NULL;
+    }
+
+    return member[-1].value.string;
+}
+
+CJSON_PUBLIC(const char *) cJSON_TapeGetStringValue(const cJSON_TapeEntry *item)
+{
+    if ((item == NULL) || (item->type != cJSON_String))
+    {
+        return NULL;
+    }
+
+    return item->value.string;
+}
+
+CJSON_PUBLIC(double) cJSON_TapeGetNumberValue(const cJSON_TapeEntry *item)
+{
+    if ((item == NULL) || (item->type != cJSON_Number))
+    {
+        return (double) NAN;
+    }
+
+    return item->value.number;
+}
+
+/* Push parser. Input is consumed byte by byte through a state machine with an explicit stack of open
+ * containers, only the token that is currently being read (a string, number or literal) is buffered.
+ * Complete tokens are decoded by parse_string and parse_number, so they follow the same rules as in
+ * cJSON_Parse. Events go to a cJSON_SaxHandler, the tree mode is a handler that builds the tree. */
+typedef enum
+{
+    stream_bom, /* inside a UTF-8 BOM */
+    stream_value, /* expecting a value */
+    stream_value_or_end, /* after '[' */
+    stream_key, /* after ',' in an object */
+    stream_key_or_end, /* after '{' */
+    stream_colon,
+    stream_comma_or_end, /* after a value in a container */
+    stream_string, /* reading a string token */
+    stream_number, /* reading a number token */
+    stream_literal, /* reading true, false or null */
+    stream_done, /* the root value is complete, the rest of the input is ignored like in cJSON_Parse */
+    stream_error
+} stream_state;
+
+typedef struct
+{
+    cJSON *root;
+    cJSON **open; /* stack of open containers */
+    size_t depth;
+    size_t capacity;
+    char *key; /* name of the member whose value comes next */
+} tree_builder;
+
+struct cJSON_StreamParser
+{
+    sax_context sax;
+    cJSON_SaxHandler tree_handler;
+    tree_builder tree;
+    stream_state state;
+    /* stack of open containers, '[' or '{' */
+    unsigned char *containers;
+    size_t depth;
+    size_t containers_capacity;
+    /* token in progress */
+    unsigned char *token;
+    size_t token_length;
+    size_t token_capacity;
+    size_t token_offset; /* stream offset of the first byte of the token */
+    cJSON_bool token_is_key;
+    cJSON_bool escape_pending; /* the last byte of the previous chunk was a backslash inside a string */
+    const char *literal; /* literal that is being matched */
+    size_t offset; /* stream offset of the start of the current chunk */
+    size_t error_offset;
+    cJSON_Arena strings;
+};
+
+static cJSON_bool tree_add(tree_builder * const tree, cJSON * const item)
+{
+    cJSON *parent = NULL;
+
+    if (item == NULL)
+    {
+        return false;
+    }
+
+    if (tree->depth == 0)
+    {
+        tree->root = item;
+        return true;
+    }
+
+    parent = tree->open[tree->depth - 1];
+    if (cJSON_IsObject(parent))
+    {
+        item->string = tree->key;
+        tree->key = NULL;
+    }
+
+    if (!cJSON_AddItemToArray(parent, item))
+    {
+        /* takes the key with it */
+        cJSON_Delete(item);
+        return false;
+    }
+
+    return true;
+}
+
+static cJSON_bool tree_null(void *user_data)
+{
+    return tree_add((tree_builder*)user_data, cJSON_CreateNull());
+}
+
+static cJSON_bool tree_boolean(void *user_data, cJSON_bool value)
+{
+    return tree_add((tree_builder*)user_data, cJSON_CreateBool(value));
+}
+
+static cJSON_bool tree_number(void *user_data, double value)
+{
+    return tree_add((tree_builder*)user_data, cJSON_CreateNumber(value));
+}
+
+static cJSON_bool tree_string(void *user_data, const char *value)
+{
+    return tree_add((tree_builder*)user_data, cJSON_CreateString(value));
+}
+
+static cJSON_bool tree_key(void *user_data, const char *key)
+{
+    tree_builder * const tree = (tree_builder*)user_data;
+
+    tree->key = (char*)cJSON_strdup((const unsigned char*)key, &global_hooks);
+
+    return tree->key != NULL;
+}
+
+static cJSON_bool tree_start(tree_builder * const tree, cJSON * const container)
+{
+    if (!tree_add(tree, container))
+    {
+        return false;
+    }
+
+    if (tree->depth == tree->capacity)
+    {
+        cJSON **open = NULL;
+        size_t capacity = (tree->capacity > 0) ? (tree->capacity * 2) : 16;
+
+        open = (cJSON**)global_hooks.allocate(global_hooks.user_data, capacity * sizeof(cJSON*));
+        if (open == NULL)
+        {
+            return false;
+        }
+        if (tree->open != NULL)
+        {
+            memcpy(open, tree->open, tree->depth * sizeof(cJSON*));
+            global_hooks.deallocate(global_hooks.user_data, tree->open);
+        }
+        tree->open = open;
+        tree->capacity = capacity;
+    }
+    tree->open[tree->depth++] = container;
+
+    return true;
+}
+
+static cJSON_bool tree_start_object(void *user_data)
+{
+    return tree_start((tree_builder*)user_data, cJSON_CreateObject());
+}
+
+static cJSON_bool tree_start_array(void *user_data)
+{
+    return tree_start((tree_builder*)user_data, cJSON_CreateArray());
+}
+
+static cJSON_bool tree_end(void *user_data)
+{
+    ((tree_builder*)user_data)->depth--;
+
+    return true;
+}
+
+CJSON_PUBLIC(cJSON_StreamParser *) cJSON_StreamParser_New(const cJSON_SaxHandler *handler, void *user_data)
+{
+    cJSON_StreamParser *parser = (cJSON_StreamParser*)global_hooks.allocate(global_hooks.user_data, sizeof(cJSON_StreamParser));
+    if (parser == NULL)
+    {
+        return NULL;
+    }
+    memset(parser, '\0', sizeof(cJSON_StreamParser));
+
+    if (handler != NULL)
+    {
+        parser->sax.handler = handler;
+        parser->sax.user_data = user_data;
+    }
+    else
+    {
+        parser->tree_handler.null_value = tree_null;
+        parser->tree_handler.boolean = tree_boolean;
+        parser->tree_handler.number = tree_number;
+        parser->tree_handler.string = tree_string;
+        parser->tree_handler.key = tree_key;
+        parser->tree_handler.start_object = tree_start_object;
+        parser->tree_handler.end_object = tree_end;
+        parser->tree_handler.start_array = tree_start_array;
+        parser->tree_handler.end_array = tree_end;
+        parser->sax.handler = &parser->tree_handler;
+        parser->sax.user_data = &parser->tree;
+    }
+    parser->sax.keep_strings = false;
+    parser->state = stream_value;
+    cJSON_ArenaInit(&parser->strings, 0);
+
+    return parser;
+}
+
+CJSON_PUBLIC(void) cJSON_StreamParser_Delete(cJSON_StreamParser *parser)
+{
+    if (parser == NULL)
+    {
+        return;
+    }
+
+    cJSON_Delete(parser->tree.root);
+    if (parser->tree.open != NULL)
+    {
+        global_hooks.deallocate(global_hooks.user_data, parser->tree.open);
+    }
+    if (parser->tree.key != NULL)
+    {
+        global_hooks.deallocate(global_hooks.user_data, parser->tree.key);
+    }
+    if (parser->containers != NULL)
+    {
+        global_hooks.deallocate(global_hooks.user_data, parser->containers);
+    }
+    if (parser->token != NULL)
+    {
+        global_hooks.deallocate(global_hooks.user_data, parser->token);
+    }
+    cJSON_ArenaFree(&parser->strings);
+    global_hooks.deallocate(global_hooks.user_data, parser);
+}
+
+static cJSON_bool stream_append_token(cJSON_StreamParser * const parser, const unsigned char * const bytes, const size_t length)
+{
+    if ((parser->token_length + length) > parser->token_capacity)
+    {
+        unsigned char *token = NULL;
+        size_t capacity = (parser->token_capacity > 0) ? parser->token_capacity : 64;
+
+        while (capacity < (parser->token_length + length))
+        {
+            capacity *= 2;
+        }
+        token = (unsigned char*)global_hooks.allocate(global_hooks.user_data, capacity);
+        if (token == NULL)
+        {
+            return false;
+        }
+        if (parser->token != NULL)
+        {
+            memcpy(token, parser->token, parser->token_length);
+            global_hooks.deallocate(global_hooks.user_data, parser->token);
+        }
+        parser->token = token;
+        parser->token_capacity = capacity;
+    }
+
+    memcpy(parser->token + parser->token_length, bytes, length);
+    parser->token_length += length;
+
+    return true;
+}
+
+/* a value is complete, continue in the enclosing container */
+static void stream_value_done(cJSON_StreamParser * const parser)
+{
+    parser->state = (parser->depth == 0) ? stream_done : stream_comma_or_end;
+}
+
+static cJSON_bool stream_push(cJSON_StreamParser * const parser, const unsigned char container)
+{
+    const cJSON_SaxHandler * const handler = parser->sax.handler;
+
+    if (parser->depth >= CJSON_NESTING_LIMIT)
+    {
+        return false; /* to deeply nested */
+    }
+
+    if (parser->depth == parser->containers_capacity)
+    {
+        unsigned char *containers = NULL;
+        size_t capacity = (parser->containers_capacity > 0) ? (parser->containers_capacity * 2) : 32;
+
+        containers = (unsigned char*)global_hooks.allocate(global_hooks.user_data, capacity);
+        if (containers == NULL)
+        {
+            return false;
+        }
+        if (parser->containers != NULL)
+        {
+            memcpy(containers, parser->containers, parser->depth);
+            global_hooks.deallocate(global_hooks.user_data, parser->containers);
+        }
+        parser->containers = containers;
+        parser->containers_capacity = capacity;
+    }
+    parser->containers[parser->depth++] = container;
+
+    if (container == '[')
+    {
+        parser->state = stream_value_or_end;
+        return (handler->start_array == NULL) || handler->start_array(parser->sax.user_data);
+    }
+
+    parser->state = stream_key_or_end;
+    return (handler->start_object == NULL) || handler->start_object(parser->sax.user_data);
+}
+
+static cJSON_bool stream_pop(cJSON_StreamParser * const parser)
+{
+    const cJSON_SaxHandler * const handler = parser->sax.handler;
+    const unsigned char container = parser->containers[--parser->depth];
+
+    stream_value_done(parser);
+    if (container == '[')
+    {
+        return (handler->end_array == NULL) || handler->end_array(parser->sax.user_data);
+    }
+
+    return (handler->end_object == NULL) || handler->end_object(parser->sax.user_data);
+}
+
+/* decode the buffered string or number token and report it */
+static cJSON_bool stream_emit_token(cJSON_StreamParser * const parser)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0, NULL }, NULL, NULL, 0 };
+    cJSON scratch;
+
+    buffer.content = parser->token;
+    buffer.length = parser->token_length;
+    buffer.hooks = global_hooks;
+    buffer.arena = &parser->strings;
+    memset(&scratch, '\0', sizeof(scratch));
+
+    if (parser->state == stream_string)
+    {
+        const cJSON_bool is_key = parser->token_is_key;
+
+        if (is_key)
+        {
+            parser->state = stream_colon;
+        }
+        else
+        {
+            stream_value_done(parser);
+        }
+        if (!sax_parse_string(&parser->sax, &buffer, is_key))
+        {
+            parser->error_offset = parser->token_offset + buffer.offset;
+            return false;
+        }
+        return true;
+    }
+
+    /* number */
+    if (!parse_number(&scratch, &buffer) || ((buffer.offset != buffer.length) && (parser->depth > 0)))
+    {
+        /* unlike at the top level, a number inside a container can't be followed by garbage */
+        parser->error_offset = parser->token_offset + buffer.offset;
+        return false;
+    }
+    stream_value_done(parser);
+    if ((parser->sax.handler->number != NULL) && !parser->sax.handler->number(parser->sax.user_data, scratch.valuedouble))
+    {
+        parser->error_offset = parser->token_offset + buffer.offset;
+        return false;
+    }
+
+    return true;
+}
+
+static void stream_start_token(cJSON_StreamParser * const parser, const stream_state state, const size_t offset)
+{
+    parser->state = state;
+    parser->token_length = 0;
+    parser->token_offset = offset;
+}
+
+/* handle one byte outside of tokens */
+static cJSON_bool stream_structural(cJSON_StreamParser * const parser, const unsigned char c, const size_t offset)
+{
+    if (c <= 32)
+    {
+        /* whitespace, the same set as buffer_skip_whitespace */
+        return true;
+    }
+
+    switch (parser->state)
+    {
+        case stream_value_or_end:
+            if (c == ']')
+            {
+                return stream_pop(parser);
+            }
+            /* fall through */
+        case stream_value:
+            if (c == '\"')
+            {
+                stream_start_token(parser, stream_string, offset);
+                parser->token_is_key = false;
+                return stream_append_token(parser, &c, 1);
+            }
+            if ((c == '-') || ((c >= '0') && (c <= '9')))
+            {
+                stream_start_token(parser, stream_number, offset);
+                return stream_append_token(parser, &c, 1);
+            }
+            if ((c == 't') || (c == 'f') || (c == 'n'))
+            {
+                stream_start_token(parser, stream_literal, offset);
+                parser->literal = (c == 't') ? "true" : ((c == 'f') ? "false" : "null");
+                parser->token_length = 1;
+                return true;
+            }
+            if ((c == '[') || (c == '{'))
+            {
+                return stream_push(parser, c);
+            }
+            return false;
+
+        case stream_key_or_end:
+            if (c == '}')
+            {
+                return stream_pop(parser);
+            }
+            /* fall through */
+        case stream_key:
+            if (c == '\"')
+            {
+                stream_start_token(parser, stream_string, offset);
+                parser->token_is_key = true;
+                return stream_append_token(parser, &c, 1);
+            }
+            return false;
+
+        case stream_colon:
+            if (c == ':')
+            {
+                parser->state = stream_value;
+                return true;
+            }
+            return false;
+
+        case stream_comma_or_end:
+            if (c == ',')
+            {
+                parser->state = (parser->containers[parser->depth - 1] == '[') ? stream_value : stream_key;
+                return true;
+            }
+            if (((c == ']') && (parser->containers[parser->depth - 1] == '[')) || ((c == '}') && (parser->containers[parser->depth - 1] == '{')))
+            {
+                return stream_pop(parser);
+            }
+            return false;
+
+        default:
+            break;
+    }
+
+    return false;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_StreamParser_Feed(cJSON_StreamParser *parser, const char *chunk, size_t length)
+{
+    const unsigned char * const input = (const unsigned char*)chunk;
+    size_t position = 0;
+
+    if ((parser == NULL) || (parser->state == stream_error) || ((chunk == NULL) && (length > 0)))
+    {
+        return false;
+    }
+
+    while ((position < length) && (parser->state != stream_done))
+    {
+        const unsigned char c = input[position];
+
+        switch (parser->state)
+        {
+            case stream_string:
+                if (parser->escape_pending)
+                {
+                    /* the escaped byte can't end the string */
+                    parser->escape_pending = false;
+                }
+                else
+                {
+                    size_t run = scan_string_special(input + position, length - position);
+                    if (run > 0)
+                    {
+                        if (!stream_append_token(parser, input + position, run))
+                        {
+                            goto fail;
+                        }
+                        position += run;
+                        continue;
+                    }
+                    if (c == '\\')
+                    {
+                        parser->escape_pending = true;
+                    }
+                    else if (c == '\"')
+                    {
+                        if (!stream_append_token(parser, &c, 1))
+                        {
+                            goto fail;
+                        }
+                        position++;
+                        if (!stream_emit_token(parser))
+                        {
+                            goto token_fail;
+                        }
+                        continue;
+                    }
+                }
+                if (!stream_append_token(parser, &c, 1))
+                {
+                    goto fail;
+                }
+                position++;
+                continue;
+
+            case stream_number:
+                if (((c >= '0') && (c <= '9')) || (c == '+') || (c == '-') || (c == '.') || (c == 'e') || (c == 'E'))
+                {
+                    if (!stream_append_token(parser, &c, 1))
+                    {
+                        goto fail;
+                    }
+                    position++;
+                    continue;
+                }
+                if (!stream_emit_token(parser))
+                {
+                    goto token_fail;
+                }
+                /* the byte that ended the number is handled by the new state */
+                continue;
+
+            case stream_literal:
+                if (c != (unsigned char)parser->literal[parser->token_length])
+                {
+                    goto fail;
+                }
+                position++;
+                if (parser->literal[++parser->token_length] == '\0')
+                {
+                    const cJSON_SaxHandler * const handler = parser->sax.handler;
+                    cJSON_bool result = true;
+
+                    stream_value_done(parser);
+                    if (parser->literal[0] == 'n')
+                    {
+                        result = (handler->null_value == NULL) || handler->null_value(parser->sax.user_data);
+                    }
+                    else if (handler->boolean != NULL)
+                    {
+                        result = handler->boolean(parser->sax.user_data, (parser->literal[0] == 't') ? true : false);
+                    }
+                    if (!result)
+                    {
+                        parser->error_offset = parser->offset + position;
+                        parser->state = stream_error;
+                        return false;
+                    }
+                }
+                continue;
+
+            case stream_bom:
+                if (c != (unsigned char)"\xEF\xBB\xBF"[parser->token_length])
+                {
+                    goto fail;
+                }
+                position++;
+                if (++parser->token_length == 3)
+                {
+                    parser->state = stream_value;
+                }
+                continue;
+
+            default:
+                if ((parser->offset + position == 0) && (c == 0xEF))
+                {
+                    /* UTF-8 BOM */
+                    stream_start_token(parser, stream_bom, 0);
+                    parser->token_length = 1;
+                    position++;
+                    continue;
+                }
+                if (!stream_structural(parser, c, parser->offset + position))
+                {
+                    goto fail;
+                }
+                position++;
+                continue;
+        }
+    }
+
+    parser->offset += length;
+    return true;
+
+fail:
+    parser->error_offset = parser->offset + position;
+    parser->state = stream_error;
+    return false;
+
+token_fail:
+    /* error_offset was set while decoding the token */
+    parser->state = stream_error;
+    return false;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_StreamParser_Finish(cJSON_StreamParser *parser)
+{
+    if ((parser == NULL) || (parser->state == stream_error))
+    {
+        return false;
+    }
+
+    if ((parser->state == stream_number) && (parser->depth == 0))
+    {
+        /* a number at the top level ends with the input */
+        if (!stream_emit_token(parser))
+        {
+            parser->state = stream_error;
+            return false;
+        }
+    }
+
+    if (parser->state != stream_done)
+    {
+        parser->error_offset = parser->offset;
+        parser->state = stream_error;
+        return false;
+    }
+
+    return true;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_StreamParser_DetachTree(cJSON_StreamParser *parser)
+{
+    cJSON *root = NULL;
+
+    if ((parser == NULL) || (parser->state != stream_done))
+    {
+        return NULL;
+    }
+
+    root = parser->tree.root;
+    parser->tree.root = NULL;
+
+    return root;
+}
+
+CJSON_PUBLIC(size_t) cJSON_StreamParser_GetErrorOffset(const cJSON_StreamParser *parser)
+{
+    if ((parser == NULL) || (parser->state != stream_error))
+    {
+        return 0;
+    }
+
+    return parser->error_offset;
+}
+
+#define cjson_min(a, b) (((a) < (b)) ? (a) : (b))
+
+static unsigned char *print(const cJSON * const item, cJSON_bool format, const internal_hooks * const hooks)
+{
+    static const size_t default_buffer_size = 256;
+    printbuffer buffer[1];
+    unsigned char *printed = NULL;
+
+    memset(buffer, 0, sizeof(buffer));
+
+    /* create buffer */
+    buffer->buffer = (unsigned char*) hooks->allocate(hooks->user_data, default_buffer_size);
+    buffer->length = default_buffer_size;
+    buffer->format = format;
+    buffer->hooks = *hooks;
+    if (buffer->buffer == NULL)
+    {
+        goto fail;
+    }
+
+    /* print the value */
+    if (!print_value(item, buffer))
+    {
+        goto fail;
+    }
+    update_offset(buffer);
+
+    /* check if reallocate is available */
+    if (hooks->reallocate != NULL)
+    {
+        printed = (unsigned char*) hooks->reallocate(hooks->user_data, buffer->buffer, buffer->offset + 1);
+        if (printed == NULL) {
+            goto fail;
+        }
+        buffer->buffer = NULL;
+    }
+    else /* otherwise copy the JSON over to a new buffer */
+    {
+        printed = (unsigned char*) hooks->allocate(hooks->user_data, buffer->offset + 1);
+        if (printed == NULL)
+        {
+            goto fail;
+        }
+        memcpy(printed, buffer->buffer, cjson_min(buffer->length, buffer->offset + 1));
+        printed[buffer->offset] = '\0'; /* just to be sure */
+
+        /* free the buffer */
+        hooks->deallocate(hooks->user_data, buffer->buffer);
+        buffer->buffer = NULL;
+    }
+
+    return printed;
+
+fail:
+    if (buffer->buffer != NULL)
+    {
+        hooks->deallocate(hooks->user_data, buffer->buffer);
+        buffer->buffer = NULL;
+    }
+
+    if (printed != NULL)
+    {
+        hooks->deallocate(hooks->user_data, printed);
+        printed = NULL;
+    }
+
+    return NULL;
+}
+
+/* Render a cJSON item/entity/structure to text. */
+CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item)
+{
+    return (char*)print(item, true, &global_hooks);
+}
+
+CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item)
+{
+    return (char*)print(item, false, &global_hooks);
+}
+
+CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt)
+{
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0, NULL }, NULL, NULL };
+
+    if (prebuffer < 0)
+    {
+        return NULL;
+    }
+
+    p.buffer = (unsigned char*)global_hooks.allocate(global_hooks.user_data, (size_t)prebuffer);
+    if (!p.buffer)
+    {
+        return NULL;
+    }
+
+    p.length = (size_t)prebuffer;
+    p.offset = 0;
+    p.noalloc = false;
+    p.format = fmt;
+    p.hooks = global_hooks;
+
+    if (!print_value(item, &p))
+    {
+        global_hooks.deallocate(global_hooks.user_data, p.buffer);
+        p.buffer = NULL;
+        return NULL;
+    }
+
+    return (char*)p.buffer;
+}
+
+#ifndef CJSON_SINK_BUFFER_SIZE
+#define CJSON_SINK_BUFFER_SIZE 4096
+#endif
+
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintToSink(const cJSON *item, cJSON_bool format, cJSON_bool (*write_fn)(void *context, const char *data, size_t length), void *context)
+{
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0, NULL }, NULL, NULL };
+    cJSON_bool success = false;
+
+    if ((item == NULL) || (write_fn == NULL))
+    {
+        return false;
+    }
+
+    p.buffer = (unsigned char*)global_hooks.allocate(global_hooks.user_data, CJSON_SINK_BUFFER_SIZE);
+    if (p.buffer == NULL)
+    {
+        return false;
+    }
+
+    p.length = CJSON_SINK_BUFFER_SIZE;
+    p.offset = 0;
+    p.noalloc = false;
+    p.format = format;
+    p.hooks = global_hooks;
+    p.sink = write_fn;
+    p.sink_context = context;
+
+    if (print_value(item, &p))
+    {
+        update_offset(&p);
+        /* the rest */
+        success = (p.offset == 0) || write_fn(context, (const char*)p.buffer, p.offset);
+    }
+
+    /* ensure frees the buffer if it can't grow it */
+    if (p.buffer != NULL)
+    {
+        global_hooks.deallocate(global_hooks.user_data, p.buffer);
+    }
+
+    return success;
+}
+
+static cJSON_bool count_printed(void *context, const char *data, size_t length)
+{
+    (void)data;
+    *(size_t*)context += length;
+
+    return true;
+}
+
+CJSON_PUBLIC(size_t) cJSON_PrintedLength(const cJSON *item, cJSON_bool format)
+{
+    size_t length = 0;
+
+    if (!cJSON_PrintToSink(item, format, count_printed, &length))
+    {
+        return 0;
+    }
+
+    return length;
+}
+
+CJSON_PUBLIC(char *) cJSON_PrintExact(const cJSON *item, cJSON_bool format)
+{
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0, NULL }, NULL, NULL };
+    const size_t length = cJSON_PrintedLength(item, format);
+
+    if (length == 0)
+    {
+        return NULL;
+    }
+
+    p.buffer = (unsigned char*)global_hooks.allocate(global_hooks.user_data, length + sizeof(""));
+    if (p.buffer == NULL)
+    {
+        return NULL;
+    }
+
+    p.length = length + sizeof("");
+    p.offset = 0;
+    p.noalloc = true;
+    p.format = format;
+    p.hooks = global_hooks;
+
+    if (!print_value(item, &p))
+    {
+        global_hooks.deallocate(global_hooks.user_data, p.buffer);
+        return NULL;
+    }
+
+    return (char*)p.buffer;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format)
+{
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0, NULL }, NULL, NULL };
+
+    if ((length < 0) || (buffer == NULL))
+    {
+        return false;
+    }
+
+    p.buffer = (unsigned char*)buffer;
+    p.length = (size_t)length;
+    p.offset = 0;
+    p.noalloc = true;
+    p.format = format;
+    p.hooks = global_hooks;
+
+    return print_value(item, &p);
+}
+
+/* Parser core - when encountering text, process appropriately. */
+static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer)
+{
+    if ((input_buffer == NULL) || (input_buffer->content == NULL))
+    {
+        return false; /* no input */
+    }
+
+    /* parse the different types of values */
+    /* null */
+    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "null", 4) == 0))
+    {
+        item->type = cJSON_NULL;
+        input_buffer->offset += 4;
+        return true;
+    }
+    /* false */
+    if (can_read(input_buffer, 5) && (strncmp((const char*)buffer_at_offset(input_buffer), "false", 5) == 0))
+    {
+        item->type = cJSON_False;
+        input_buffer->offset += 5;
+        return true;
+    }
+    /* true */
+    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "true", 4) == 0))
+    {
+        item->type = cJSON_True;
+        item->valueint = 1;
+        input_buffer->offset += 4;
+        return true;
+    }
+    /* string */
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '\"'))
+    {
+        return parse_string(item, input_buffer);
+    }
+    /* number */
+    if (can_access_at_index(input_buffer, 0) && ((buffer_at_offset(input_buffer)[0] == '-') || ((buffer_at_offset(input_buffer)[0] >= '0') && (buffer_at_offset(input_buffer)[0] <= '9'))))
+    {
+        return parse_number(item, input_buffer);
+    }
+    /* array */
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '['))
+    {
+        return parse_array(item, input_buffer);
+    }
+    /* object */
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '{'))
+    {
+        return parse_object(item, input_buffer);
+    }
+
+    parse_fail_unexpected(input_buffer);
+    return false;
+}
+
+/* Render a value to text. */
+static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output = NULL;
+
+    if ((item == NULL) || (output_buffer == NULL))
+    {
+        return false;
+    }
+
+    switch ((item->type) & 0xFF)
+    {
+        case cJSON_NULL:
+            output = ensure(output_buffer, 5);
+            if (output == NULL)
+            {
+                return false;
+            }
+            strcpy((char*)output, "null");
+            return true;
+
+        case cJSON_False:
+            output = ensure(output_buffer, 6);
+            if (output == NULL)
+            {
+                return false;
+            }
+            strcpy((char*)output, "false");
+            return true;
+
+        case cJSON_True:
+            output = ensure(output_buffer, 5);
+            if (output == NULL)
+            {
+                return false;
+            }
+            strcpy((char*)output, "true");
+            return true;
+
+        case cJSON_Number:
+            return print_number(item, output_buffer);
+
+        case cJSON_Raw:
+        {
+            size_t raw_length = 0;
+            if (item->valuestring == NULL)
+            {
+                return false;
+            }
+
+            raw_length = strlen(item->valuestring) + sizeof("");
+            output = ensure(output_buffer, raw_length);
+            if (output == NULL)
+            {
+                return false;
+            }
+            memcpy(output, item->valuestring, raw_length);
+            return true;
+        }
+
+        case cJSON_String:
+            return print_string(item, output_buffer);
+
+        case cJSON_Array:
+            return print_array(item, output_buffer);
+
+        case cJSON_Object:
+            return print_object(item, output_buffer);
+
+        default:
+            return false;
+    }
+}
+
+/* Build an array from input text. */
+static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer)
+{
+    cJSON *head = NULL; /* head of the linked list */
+    cJSON *current_item = NULL;
+
+    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    {
+        parse_fail(input_buffer, cJSON_ParseErrorTooDeep);
+        return false; /* to deeply nested */
+    }
+    input_buffer->depth++;
+
+    if (buffer_at_offset(input_buffer)[0] != '[')
+    {
+        /* not an array */
+        goto fail;
+    }
+
+    input_buffer->offset++;
+    buffer_skip_whitespace(input_buffer);
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ']'))
+    {
+        /* empty array */
+        goto success;
+    }
+
+    /* check if we skipped to the end of the buffer */
+    if (cannot_access_at_index(input_buffer, 0))
+    {
+        parse_fail(input_buffer, cJSON_ParseErrorUnexpectedEnd);
+        input_buffer->offset--;
+        goto fail;
+    }
+
+    /* step back to character in front of the first element */
+    input_buffer->offset--;
+    /* loop through the comma separated array elements */
+    do
+    {
+        /* allocate next item */
+        cJSON *new_item = parse_new_item(input_buffer);
+        if (new_item == NULL)
+        {
+            parse_fail(input_buffer, cJSON_ParseErrorOutOfMemory);
+            goto fail; /* allocation failure */
+        }
+
+        /* attach next item to list */
+        if (head == NULL)
+        {
+            /* start the linked list */
+            current_item = head = new_item;
+        }
+        else
+        {
+            /* add to the end and advance */
+            current_item->next = new_item;
+            new_item->prev = current_item;
+            current_item = new_item;
+        }
+
+        /* parse next value */
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if (!parse_value(current_item, input_buffer))
+        {
+            goto fail; /* failed to parse value */
+        }
+        parse_mark_item(input_buffer, current_item);
+        buffer_skip_whitespace(input_buffer);
+    }
+    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
+
+    if (cannot_access_at_index(input_buffer, 0) || buffer_at_offset(input_buffer)[0] != ']')
+    {
+        parse_fail_unexpected(input_buffer);
+        goto fail; /* expected end of array */
+    }
+
+success:
+    input_buffer->depth--;
+
+    if (head != NULL) {
+        head->prev = current_item;
+    }
+
+    item->type = cJSON_Array;
+    item->child = head;
+
+    input_buffer->offset++;
+
+    return true;
+
+fail:
+    if (head != NULL)
+    {
+        parse_delete(input_buffer, head);
+    }
+
+    return false;
+}
+
+/* Render an array to text */
+static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
+    size_t length = 0;
+    cJSON *current_element = item->child;
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    /* Compose the output array. */
+    /* opening square bracket */
+    output_pointer = ensure(output_buffer, 1);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+
+    *output_pointer = '[';
+    output_buffer->offset++;
+    output_buffer->depth++;
+
+    while (current_element != NULL)
+    {
+        if (!print_value(current_element, output_buffer))
+        {
+            return false;
+        }
+        update_offset(output_buffer);
+        if (current_element->next)
+        {
+            length = (size_t) (output_buffer->format ? 2 : 1);
+            output_pointer = ensure(output_buffer, length + 1);
+            if (output_pointer == NULL)
+            {
+                return false;
+            }
+            *output_pointer++ = ',';
+            if(output_buffer->format)
+            {
+                *output_pointer++ = ' ';
+            }
+            *output_pointer = '\0';
+            output_buffer->offset += length;
+        }
+        current_element = current_element->next;
+    }
+
+    output_pointer = ensure(output_buffer, 2);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+    *output_pointer++ = ']';
+    *output_pointer = '\0';
+    output_buffer->depth--;
+
+    return true;
+}
+
+/* Build an object from the text. */
+static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer)
+{
+    cJSON *head = NULL; /* linked list head */
+    cJSON *current_item = NULL;
+
+    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    {
+        parse_fail(input_buffer, cJSON_ParseErrorTooDeep);
+        return false; /* to deeply nested */
+    }
+    input_buffer->depth++;
+
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '{'))
+    {
+        goto fail; /* not an object */
+    }
+
+    input_buffer->offset++;
+    buffer_skip_whitespace(input_buffer);
+    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '}'))
+    {
+        goto success; /* empty object */
+    }
+
+    /* check if we skipped to the end of the buffer */
+    if (cannot_access_at_index(input_buffer, 0))
+    {
+        parse_fail(input_buffer, cJSON_ParseErrorUnexpectedEnd);
+        input_buffer->offset--;
+        goto fail;
+    }
+
+    /* step back to character in front of the first element */
+    input_buffer->offset--;
+    /* loop through the comma separated array elements */
+    do
+    {
+        int name_flags = 0;
+        /* allocate next item */
+        cJSON *new_item = parse_new_item(input_buffer);
+        if (new_item == NULL)
+        {
+            parse_fail(input_buffer, cJSON_ParseErrorOutOfMemory);
+            goto fail; /* allocation failure */
+        }
+
+        /* attach next item to list */
+        if (head == NULL)
+        {
+            /* start the linked list */
+            current_item = head = new_item;
+        }
+        else
+        {
+            /* add to the end and advance */
+            current_item->next = new_item;
+            new_item->prev = current_item;
+            current_item = new_item;
+        }
+
+        if (cannot_access_at_index(input_buffer, 1))
+        {
+            parse_fail(input_buffer, cJSON_ParseErrorUnexpectedEnd);
+            goto fail; /* nothing comes after the comma */
+        }
+
+        /* parse the name of the child */
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if (!parse_string(current_item, input_buffer))
+        {
+            goto fail; /* failed to parse name */
+        }
+        buffer_skip_whitespace(input_buffer);
+
+        /* swap valuestring and string, because we parsed the name */
+        current_item->string = current_item->valuestring;
+        current_item->valuestring = NULL;
+        if (current_item->type & cJSON_IsReference)
+        {
+            /* the name was terminated in place, parse_value overwrites the type so keep the flag aside */
+            name_flags = cJSON_StringIsConst | cJSON_StringInPlace;
+            current_item->type = name_flags;
+        }
+
+        if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
+        {
+            parse_fail_unexpected(input_buffer);
+            goto fail; /* invalid object */
+        }
+
+        /* parse the value */
+        input_buffer->offset++;
+        buffer_skip_whitespace(input_buffer);
+        if (!parse_value(current_item, input_buffer))
+        {
+            goto fail; /* failed to parse value */
+        }
+        current_item->type |= name_flags;
+        parse_mark_item(input_buffer, current_item);
+        buffer_skip_whitespace(input_buffer);
+    }
+    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
+
+    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '}'))
+    {
+        parse_fail_unexpected(input_buffer);
+        goto fail; /* expected end of object */
+    }
+
+success:
+    input_buffer->depth--;
+
+    if (head != NULL) {
+        head->prev = current_item;
+    }
+
+    item->type = cJSON_Object;
+    item->child = head;
+
+    input_buffer->offset++;
+    return true;
+
+fail:
+    if (head != NULL)
+    {
+        parse_delete(input_buffer, head);
+    }
+
+    return false;
+}
+
+/* Render an object to text. */
+static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
+    size_t length = 0;
+    cJSON *current_item = item->child;
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    /* Compose the output: */
+    length = (size_t) (output_buffer->format ? 2 : 1); /* fmt: {\n */
+    output_pointer = ensure(output_buffer, length + 1);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+
+    *output_pointer++ = '{';
+    output_buffer->depth++;
+    if (output_buffer->format)
+    {
+        *output_pointer++ = '\n';
+    }
+    output_buffer->offset += length;
+
+    while (current_item)
+    {
+        if (output_buffer->format)
+        {
+            size_t i;
+            output_pointer = ensure(output_buffer, output_buffer->depth);
+            if (output_pointer == NULL)
+            {
+                return false;
+            }
+            for (i = 0; i < output_buffer->depth; i++)
+            {
+                *output_pointer++ = '\t';
+            }
+            output_buffer->offset += output_buffer->depth;
+        }
+
+        /* print key */
+        if (!print_string_ptr((unsigned char*)current_item->string, output_buffer))
+        {
+            return false;
+        }
+        update_offset(output_buffer);
+
+        length = (size_t) (output_buffer->format ? 2 : 1);
+        output_pointer = ensure(output_buffer, length);
+        if (output_pointer == NULL)
+        {
+            return false;
+        }
+        *output_pointer++ = ':';
+        if (output_buffer->format)
+        {
+            *output_pointer++ = '\t';
+        }
+        output_buffer->offset += length;
+
+        /* print value */
+        if (!print_value(current_item, output_buffer))
+        {
+            return false;
+        }
+        update_offset(output_buffer);
+
+        /* print comma if not last */
+        length = ((size_t)(output_buffer->format ? 1 : 0) + (size_t)(current_item->next ? 1 : 0));
+        output_pointer = ensure(output_buffer, length + 1);
+        if (output_pointer == NULL)
+        {
+            return false;
+        }
+        if (current_item->next)
+        {
+            *output_pointer++ = ',';
+        }
+
+        if (output_buffer->format)
+        {
+            *output_pointer++ = '\n';
+        }
+        *output_pointer = '\0';
+        output_buffer->offset += length;
+
+        current_item = current_item->next;
+    }
+
+    output_pointer = ensure(output_buffer, output_buffer->format ? (output_buffer->depth + 1) : 2);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+    if (output_buffer->format)
+    {
+        size_t i;
+        for (i = 0; i < (output_buffer->depth - 1); i++)
+        {
+            *output_pointer++ = '\t';
+        }
+    }
+    *output_pointer++ = '}';
+    *output_pointer = '\0';
+    output_buffer->depth--;
+
+    return true;
+}
+
+#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
+    #pragma GCC diagnostic push
+#endif
+#ifdef __GNUC__
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+/* helper function to cast away const */
+static void* cast_away_const(const void* string)
+{
+    return (void*)string;
 }
+#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
+    #pragma GCC diagnostic pop
+#endif
 
-/* Parser core - when encountering text, process appropriately. */
-static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer)
+/* Lookup index of an array or object, kept in sync by every function that links or unlinks children.
+ * It caches the number of children and holds either a vector of the children in list order (arrays
+ * that opted in with cJSON_IndexArray) or a hash table of the members (objects that opted in with
+ * cJSON_IndexObject). Lookups only read it, so they stay safe on trees shared between threads. Big arrays and
+ * objects also get one from cJSON_MemoizeHash to keep their hash in.
+ *
+ * Keys are hashed case insensitively so one table serves both lookup flavours. An object with
+ * duplicate keys, or keys that only differ in case, is marked ambiguous and keeps using the linear
+ * search, which returns the first of them. */
+typedef struct index_slot
 {
-    if ((input_buffer == NULL) || (input_buffer->content == NULL))
-    {
-        return false; /* no input */
-    }
+    cJSON *item;
+    size_t hash;
+} index_slot;
 
-    /* parse the different types of values */
-    /* null */
-    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "null", 4) == 0))
-    {
-        item->type = cJSON_NULL;
-        input_buffer->offset += 4;
-        return true;
-    }
-    /* false */
-    if (can_read(input_buffer, 5) && (strncmp((const char*)buffer_at_offset(input_buffer), "false", 5) == 0))
-    {
-        item->type = cJSON_False;
-        input_buffer->offset += 5;
-        return true;
-    }
-    /* true */
-    if (can_read(input_buffer, 4) && (strncmp((const char*)buffer_at_offset(input_buffer), "true", 4) == 0))
-    {
-        item->type = cJSON_True;
-        item->valueint = 1;
-        input_buffer->offset += 4;
-        return true;
-    }
-    /* string */
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '\"'))
+typedef struct cJSON_Index
+{
+    /* the index and its arrays are allocated with these, the hooks of the tree it belongs to */
+    const internal_hooks *hooks;
+    size_t count; /* number of children */
+    /* children in list order */
+    cJSON **items;
+    size_t items_capacity;
+    /* open addressing hash table of the members */
+    index_slot *slots;
+    size_t capacity; /* power of two */
+    size_t used; /* slots that are live or deleted */
+    cJSON_bool ambiguous;
+    /* taken by cJSON_MemoizeHash: the hash and the one cJSON_Compare checks, only valid in hash_epoch */
+    cJSON_bool hashed;
+    long hash_epoch;
+    cJSON_hash hash;
+    cJSON_hash compare_hash;
+} cJSON_Index;
+
+/* Arrays and objects have no use for valuestring, so the index of an indexed one is kept there. */
+#define get_index(item) ((((item)->type & (cJSON_Array | cJSON_Object)) != 0) ? (cJSON_Index*)(void*)(item)->valuestring : NULL)
+#define set_index(item, index) ((item)->valuestring = (char*)(void*)(index))
+
+#define INDEX_MINIMUM_CAPACITY 16
+
+/* marks the slot of a removed member, probing has to continue past it */
+static cJSON index_tombstone;
+
+static size_t hash_key(const unsigned char *key)
+{
+    size_t hash = 5381;
+    for (; *key != '\0'; key++)
     {
-        return parse_string(item, input_buffer);
+        hash = (hash * 33) ^ (size_t)tolower(*key);
     }
-    /* number */
-    if (can_access_at_index(input_buffer, 0) && ((buffer_at_offset(input_buffer)[0] == '-') || ((buffer_at_offset(input_buffer)[0] >= '0') && (buffer_at_offset(input_buffer)[0] <= '9'))))
+
+    return hash;
+}
+
+static void index_drop_table(cJSON_Index * const index)
+{
+    if (index->slots != NULL)
     {
-        return parse_number(item, input_buffer);
+        index->hooks->deallocate(index->hooks->user_data, index->slots);
+        index->slots = NULL;
     }
-    /* array */
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '['))
+    index->capacity = 0;
+    index->used = 0;
+}
+
+static void index_delete(cJSON_Index * const index)
+{
+    const internal_hooks * const hooks = index->hooks;
+
+    index_drop_table(index);
+    if (index->items != NULL)
     {
-        return parse_array(item, input_buffer);
+        hooks->deallocate(hooks->user_data, index->items);
     }
-    /* object */
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '{'))
+    hooks->deallocate(hooks->user_data, index);
+}
+
+static void index_drop(cJSON * const item)
+{
+    if ((item == NULL) || (get_index(item) == NULL))
     {
-        return parse_object(item, input_buffer);
+        return;
     }
 
-    return false;
+    index_delete(get_index(item));
+    set_index(item, NULL);
 }
 
-/* Render a value to text. */
-static cJSON_bool print_value(const cJSON * const item, printbuffer * const output_buffer)
+/* attaches an index that only counts the children to an array or object */
+static cJSON_Index *index_create(cJSON * const item, const internal_hooks * const hooks)
 {
-    unsigned char *output = NULL;
+    cJSON_Index *index = (cJSON_Index*)hooks->allocate(hooks->user_data, sizeof(cJSON_Index));
+    cJSON *child = NULL;
 
-    if ((item == NULL) || (output_buffer == NULL))
+    if (index == NULL)
     {
-        return false;
+        return NULL;
     }
+    memset(index, '\0', sizeof(cJSON_Index));
+    index->hooks = hooks;
 
-    switch ((item->type) & 0xFF)
+    for (child = item->child; child != NULL; child = child->next)
     {
-        case cJSON_NULL:
-            output = ensure(output_buffer, 5);
-            if (output == NULL)
-            {
-                return false;
-            }
-            strcpy((char*)output, "null");
-            return true;
-
-        case cJSON_False:
-            output = ensure(output_buffer, 6);
-            if (output == NULL)
-            {
-                return false;
-            }
-            strcpy((char*)output, "false");
-            return true;
+        index->count++;
+    }
+    set_index(item, index);
 
-        case cJSON_True:
-            output = ensure(output_buffer, 5);
-            if (output == NULL)
-            {
-                return false;
-            }
-            strcpy((char*)output, "true");
-            return true;
+    return index;
+}
 
-        case cJSON_Number:
-            return print_number(item, output_buffer);
+/* inserts a member, the table needs to have room for it */
+static void index_insert(cJSON_Index * const index, cJSON * const item, const size_t hash)
+{
+    const size_t mask = index->capacity - 1;
+    index_slot *free_slot = NULL;
+    size_t position = hash & mask;
 
-        case cJSON_Raw:
+    for (; index->slots[position].item != NULL; position = (position + 1) & mask)
+    {
+        index_slot * const slot = &index->slots[position];
+        if (slot->item == &index_tombstone)
         {
-            size_t raw_length = 0;
-            if (item->valuestring == NULL)
-            {
-                return false;
-            }
-
-            raw_length = strlen(item->valuestring) + sizeof("");
-            output = ensure(output_buffer, raw_length);
-            if (output == NULL)
+            if (free_slot == NULL)
             {
-                return false;
+                free_slot = slot;
             }
-            memcpy(output, item->valuestring, raw_length);
-            return true;
         }
+        else if ((slot->hash == hash) && (case_insensitive_strcmp((const unsigned char*)item->string, (const unsigned char*)slot->item->string) == 0))
+        {
+            index->ambiguous = true;
+            return;
+        }
+    }
 
-        case cJSON_String:
-            return print_string(item, output_buffer);
-
-        case cJSON_Array:
-            return print_array(item, output_buffer);
-
-        case cJSON_Object:
-            return print_object(item, output_buffer);
-
-        default:
-            return false;
+    if (free_slot == NULL)
+    {
+        free_slot = &index->slots[position];
+        index->used++;
     }
+    free_slot->item = item;
+    free_slot->hash = hash;
 }
 
-/* Build an array from input text. */
-static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buffer)
+static cJSON_bool index_resize(cJSON_Index * const index, const size_t count)
 {
-    cJSON *head = NULL; /* head of the linked list */
-    cJSON *current_item = NULL;
+    index_slot *old_slots = index->slots;
+    size_t old_capacity = index->capacity;
+    size_t capacity = INDEX_MINIMUM_CAPACITY;
+    size_t i = 0;
 
-    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    /* keep the load factor at or below one half */
+    while (capacity < (count * 2))
     {
-        return false; /* to deeply nested */
+        capacity *= 2;
     }
-    input_buffer->depth++;
 
-    if (buffer_at_offset(input_buffer)[0] != '[')
+    index->slots = (index_slot*)index->hooks->allocate(index->hooks->user_data, capacity * sizeof(index_slot));
+    if (index->slots == NULL)
     {
-        /* not an array */
-        goto fail;
+        index->slots = old_slots;
+        return false;
     }
+    memset(index->slots, '\0', capacity * sizeof(index_slot));
+    index->capacity = capacity;
+    index->used = 0;
 
-    input_buffer->offset++;
-    buffer_skip_whitespace(input_buffer);
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ']'))
+    for (i = 0; i < old_capacity; i++)
     {
-        /* empty array */
-        goto success;
+        if ((old_slots[i].item != NULL) && (old_slots[i].item != &index_tombstone))
+        {
+            index_insert(index, old_slots[i].item, old_slots[i].hash);
+        }
     }
-
-    /* check if we skipped to the end of the buffer */
-    if (cannot_access_at_index(input_buffer, 0))
+    if (old_slots != NULL)
     {
-        input_buffer->offset--;
-        goto fail;
+        index->hooks->deallocate(index->hooks->user_data, old_slots);
     }
 
-    /* step back to character in front of the first element */
-    input_buffer->offset--;
-    /* loop through the comma separated array elements */
-    do
-    {
-        /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
-        if (new_item == NULL)
-        {
-            goto fail; /* allocation failure */
-        }
+    return true;
+}
 
-        /* attach next item to list */
-        if (head == NULL)
-        {
-            /* start the linked list */
-            current_item = head = new_item;
-        }
-        else
-        {
-            /* add to the end and advance */
-            current_item->next = new_item;
-            new_item->prev = current_item;
-            current_item = new_item;
-        }
+static const index_slot *index_find_slot(const cJSON_Index * const index, const char * const name)
+{
+    const size_t mask = index->capacity - 1;
+    const size_t hash = hash_key((const unsigned char*)name);
+    size_t position = hash & mask;
 
-        /* parse next value */
-        input_buffer->offset++;
-        buffer_skip_whitespace(input_buffer);
-        if (!parse_value(current_item, input_buffer))
+    for (; index->slots[position].item != NULL; position = (position + 1) & mask)
+    {
+        const index_slot * const slot = &index->slots[position];
+        if ((slot->item != &index_tombstone) && (slot->hash == hash) && (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)slot->item->string) == 0))
         {
-            goto fail; /* failed to parse value */
+            return slot;
         }
-        buffer_skip_whitespace(input_buffer);
     }
-    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
-
-    if (cannot_access_at_index(input_buffer, 0) || buffer_at_offset(input_buffer)[0] != ']')
-    {
-        goto fail; /* expected end of array */
-    }
-
-success:
-    input_buffer->depth--;
 
-    if (head != NULL) {
-        head->prev = current_item;
-    }
+    return NULL;
+}
 
-    item->type = cJSON_Array;
-    item->child = head;
+static cJSON *index_find(const cJSON_Index * const index, const char * const name)
+{
+    const index_slot * const slot = index_find_slot(index, name);
 
-    input_buffer->offset++;
+    return (slot != NULL) ? slot->item : NULL;
+}
 
-    return true;
+/* Returns the index of an object if it has a hash table, or NULL if the linear search has to be used. */
+static const cJSON_Index *get_object_index(const cJSON * const object)
+{
+    const cJSON_Index * const index = get_index(object);
 
-fail:
-    if (head != NULL)
+    if ((index == NULL) || (index->slots == NULL))
     {
-        cJSON_Delete(head);
+        return NULL;
     }
 
-    return false;
+    return index;
 }
 
-/* Render an array to text */
-static cJSON_bool print_array(const cJSON * const item, printbuffer * const output_buffer)
+/* (Re)builds the hash table of an object's index from its members. An object with duplicate keys is
+ * marked ambiguous and left without a table. Returns false if out of memory, also without a table. */
+static cJSON_bool index_build_table(cJSON_Index * const index, const cJSON * const object)
 {
-    unsigned char *output_pointer = NULL;
-    size_t length = 0;
-    cJSON *current_element = item->child;
+    cJSON *child = NULL;
 
-    if (output_buffer == NULL)
+    index_drop_table(index);
+    index->ambiguous = false;
+    if (!index_resize(index, index->count))
     {
         return false;
     }
 
-    /* Compose the output array. */
-    /* opening square bracket */
-    output_pointer = ensure(output_buffer, 1);
-    if (output_pointer == NULL)
+    for (child = object->child; (child != NULL) && !index->ambiguous; child = child->next)
     {
-        return false;
+        if (child->string != NULL)
+        {
+            index_insert(index, child, hash_key((const unsigned char*)child->string));
+        }
+    }
+    if (index->ambiguous)
+    {
+        index_drop_table(index);
     }
 
-    *output_pointer = '[';
-    output_buffer->offset++;
-    output_buffer->depth++;
+    return true;
+}
 
-    while (current_element != NULL)
-    {
-        if (!print_value(current_element, output_buffer))
-        {
-            return false;
-        }
-        update_offset(output_buffer);
-        if (current_element->next)
-        {
-            length = (size_t) (output_buffer->format ? 2 : 1);
-            output_pointer = ensure(output_buffer, length + 1);
-            if (output_pointer == NULL)
-            {
-                return false;
-            }
-            *output_pointer++ = ',';
-            if(output_buffer->format)
-            {
-                *output_pointer++ = ' ';
-            }
-            *output_pointer = '\0';
-            output_buffer->offset += length;
-        }
-        current_element = current_element->next;
+static cJSON_bool index_reserve_items(cJSON_Index * const index, const size_t count)
+{
+    cJSON **items = NULL;
+    size_t capacity = (index->items_capacity > 0) ? index->items_capacity : INDEX_MINIMUM_CAPACITY;
+
+    while (capacity < count)
+    {
+        capacity *= 2;
+    }
+    if (capacity == index->items_capacity)
+    {
+        return true;
     }
 
-    output_pointer = ensure(output_buffer, 2);
-    if (output_pointer == NULL)
+    items = (cJSON**)index->hooks->allocate(index->hooks->user_data, capacity * sizeof(cJSON*));
+    if (items == NULL)
     {
         return false;
     }
-    *output_pointer++ = ']';
-    *output_pointer = '\0';
-    output_buffer->depth--;
+    if (index->items != NULL)
+    {
+        memcpy(items, index->items, index->count * sizeof(cJSON*));
+        index->hooks->deallocate(index->hooks->user_data, index->items);
+    }
+    index->items = items;
+    index->items_capacity = capacity;
 
     return true;
 }
 
-/* Build an object from the text. */
-static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_buffer)
+static size_t index_position(const cJSON_Index * const index, const cJSON * const item)
 {
-    cJSON *head = NULL; /* linked list head */
-    cJSON *current_item = NULL;
+    size_t position = 0;
+    while ((position < index->count) && (index->items[position] != item))
+    {
+        position++;
+    }
 
-    if (input_buffer->depth >= CJSON_NESTING_LIMIT)
+    return position;
+}
+
+static void index_hash_add(cJSON * const parent, cJSON * const item)
+{
+    cJSON_Index * const index = get_index(parent);
+
+    if ((index->slots == NULL) || (item->string == NULL))
     {
-        return false; /* to deeply nested */
+        return;
     }
-    input_buffer->depth++;
 
-    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '{'))
+    if (((index->used + 1) * 4) > (index->capacity * 3))
     {
-        goto fail; /* not an object */
+        if (!index_resize(index, index->count + 1))
+        {
+            index_drop(parent);
+            return;
+        }
     }
 
-    input_buffer->offset++;
-    buffer_skip_whitespace(input_buffer);
-    if (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == '}'))
+    index_insert(index, item, hash_key((const unsigned char*)item->string));
+    if (index->ambiguous)
     {
-        goto success; /* empty object */
+        index_drop_table(index);
     }
+}
 
-    /* check if we skipped to the end of the buffer */
-    if (cannot_access_at_index(input_buffer, 0))
+static void index_hash_remove(cJSON_Index * const index, const cJSON * const item)
+{
+    size_t mask = 0;
+    size_t position = 0;
+
+    if ((index->slots == NULL) || (item->string == NULL))
     {
-        input_buffer->offset--;
-        goto fail;
+        return;
     }
 
-    /* step back to character in front of the first element */
-    input_buffer->offset--;
-    /* loop through the comma separated array elements */
-    do
+    mask = index->capacity - 1;
+    for (position = hash_key((const unsigned char*)item->string) & mask; index->slots[position].item != NULL; position = (position + 1) & mask)
     {
-        /* allocate next item */
-        cJSON *new_item = cJSON_New_Item(&(input_buffer->hooks));
-        if (new_item == NULL)
+        if (index->slots[position].item == item)
         {
-            goto fail; /* allocation failure */
+            index->slots[position].item = &index_tombstone;
+            return;
         }
+    }
+}
 
-        /* attach next item to list */
-        if (head == NULL)
-        {
-            /* start the linked list */
-            current_item = head = new_item;
-        }
-        else
-        {
-            /* add to the end and advance */
-            current_item->next = new_item;
-            new_item->prev = current_item;
-            current_item = new_item;
-        }
+/* keep an existing index in sync with a child that was linked in at the given position */
+static void index_link(cJSON * const parent, cJSON * const item, const size_t position)
+{
+    cJSON_Index * const index = get_index(parent);
 
-        if (cannot_access_at_index(input_buffer, 1))
-        {
-            goto fail; /* nothing comes after the comma */
-        }
+    trees_changed();
 
-        /* parse the name of the child */
-        input_buffer->offset++;
-        buffer_skip_whitespace(input_buffer);
-        if (!parse_string(current_item, input_buffer))
+    if (index == NULL)
+    {
+        return;
+    }
+
+    index->hashed = false;
+    if (index->items != NULL)
+    {
+        if ((position > index->count) || !index_reserve_items(index, index->count + 1))
         {
-            goto fail; /* failed to parse name */
+            index_drop(parent);
+            return;
         }
-        buffer_skip_whitespace(input_buffer);
+        memmove(index->items + position + 1, index->items + position, (index->count - position) * sizeof(cJSON*));
+        index->items[position] = item;
+    }
+    index->count++;
 
-        /* swap valuestring and string, because we parsed the name */
-        current_item->string = current_item->valuestring;
-        current_item->valuestring = NULL;
+    index_hash_add(parent, item);
+}
 
-        if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
-        {
-            goto fail; /* invalid object */
-        }
+/* keep an existing index in sync with a child that was unlinked */
+static void index_unlink(cJSON * const parent, const cJSON * const item)
+{
+    cJSON_Index * const index = get_index(parent);
+    size_t position = 0;
 
-        /* parse the value */
-        input_buffer->offset++;
-        buffer_skip_whitespace(input_buffer);
-        if (!parse_value(current_item, input_buffer))
+    trees_changed();
+
+    if (index == NULL)
+    {
+        return;
+    }
+
+    index->hashed = false;
+    if (index->items != NULL)
+    {
+        position = index_position(index, item);
+        if (position == index->count)
         {
-            goto fail; /* failed to parse value */
+            index_drop(parent);
+            return;
         }
-        buffer_skip_whitespace(input_buffer);
+        memmove(index->items + position, index->items + position + 1, (index->count - position - 1) * sizeof(cJSON*));
     }
-    while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
+    index->count--;
 
-    if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != '}'))
+    if (index->ambiguous)
     {
-        goto fail; /* expected end of object */
+        /* the duplicate might be gone now, without memory the linear search is used */
+        (void)index_build_table(index, parent);
+        return;
     }
 
-success:
-    input_buffer->depth--;
+    index_hash_remove(index, item);
+}
 
-    if (head != NULL) {
-        head->prev = current_item;
-    }
+static void index_replace(cJSON * const parent, const cJSON * const item, cJSON * const replacement)
+{
+    cJSON_Index * const index = get_index(parent);
+    size_t position = 0;
 
-    item->type = cJSON_Object;
-    item->child = head;
+    trees_changed();
 
-    input_buffer->offset++;
-    return true;
+    if (index == NULL)
+    {
+        return;
+    }
 
-fail:
-    if (head != NULL)
+    index->hashed = false;
+    if (index->items != NULL)
+    {
+        position = index_position(index, item);
+        if (position == index->count)
+        {
+            index_drop(parent);
+            return;
+        }
+        index->items[position] = replacement;
+    }
+
+    if (index->ambiguous)
     {
-        cJSON_Delete(head);
+        (void)index_build_table(index, parent);
+        return;
     }
 
-    return false;
+    index_hash_remove(index, item);
+    index_hash_add(parent, replacement);
 }
 
-/* Render an object to text. */
-static cJSON_bool print_object(const cJSON * const item, printbuffer * const output_buffer)
+/* an existing index keeps the hooks it was made with */
+static cJSON_bool index_array(cJSON * const array, const internal_hooks * const hooks)
 {
-    unsigned char *output_pointer = NULL;
-    size_t length = 0;
-    cJSON *current_item = item->child;
+    cJSON_Index *index = NULL;
+    cJSON *child = NULL;
+    size_t position = 0;
 
-    if (output_buffer == NULL)
+    if (!cJSON_IsArray(array) || (array->type & (cJSON_IsReference | cJSON_ArenaOwned)))
     {
         return false;
     }
 
-    /* Compose the output: */
-    length = (size_t) (output_buffer->format ? 2 : 1); /* fmt: {\n */
-    output_pointer = ensure(output_buffer, length + 1);
-    if (output_pointer == NULL)
+    index = get_index(array);
+    if ((index != NULL) && (index->items != NULL))
     {
-        return false;
+        return true;
     }
 
-    *output_pointer++ = '{';
-    output_buffer->depth++;
-    if (output_buffer->format)
+    if ((index == NULL) && ((index = index_create(array, hooks)) == NULL))
     {
-        *output_pointer++ = '\n';
+        return false;
     }
-    output_buffer->offset += length;
-
-    while (current_item)
+    if (!index_reserve_items(index, index->count))
     {
-        if (output_buffer->format)
-        {
-            size_t i;
-            output_pointer = ensure(output_buffer, output_buffer->depth);
-            if (output_pointer == NULL)
-            {
-                return false;
-            }
-            for (i = 0; i < output_buffer->depth; i++)
-            {
-                *output_pointer++ = '\t';
-            }
-            output_buffer->offset += output_buffer->depth;
-        }
-
-        /* print key */
-        if (!print_string_ptr((unsigned char*)current_item->string, output_buffer))
-        {
-            return false;
-        }
-        update_offset(output_buffer);
+        return false;
+    }
 
-        length = (size_t) (output_buffer->format ? 2 : 1);
-        output_pointer = ensure(output_buffer, length);
-        if (output_pointer == NULL)
-        {
-            return false;
-        }
-        *output_pointer++ = ':';
-        if (output_buffer->format)
-        {
-            *output_pointer++ = '\t';
-        }
-        output_buffer->offset += length;
+    for (child = array->child; child != NULL; child = child->next)
+    {
+        index->items[position++] = child;
+    }
 
-        /* print value */
-        if (!print_value(current_item, output_buffer))
-        {
-            return false;
-        }
-        update_offset(output_buffer);
+    return true;
+}
 
-        /* print comma if not last */
-        length = ((size_t)(output_buffer->format ? 1 : 0) + (size_t)(current_item->next ? 1 : 0));
-        output_pointer = ensure(output_buffer, length + 1);
-        if (output_pointer == NULL)
-        {
-            return false;
-        }
-        if (current_item->next)
-        {
-            *output_pointer++ = ',';
-        }
+CJSON_PUBLIC(cJSON_bool) cJSON_IndexArray(cJSON *array)
+{
+    return index_array(array, &global_hooks);
+}
 
-        if (output_buffer->format)
-        {
-            *output_pointer++ = '\n';
-        }
-        *output_pointer = '\0';
-        output_buffer->offset += length;
+static cJSON_bool index_object(cJSON * const object, const internal_hooks * const hooks)
+{
+    cJSON_Index *index = NULL;
 
-        current_item = current_item->next;
+    if (!cJSON_IsObject(object) || (object->type & (cJSON_IsReference | cJSON_ArenaOwned)))
+    {
+        return false;
     }
 
-    output_pointer = ensure(output_buffer, output_buffer->format ? (output_buffer->depth + 1) : 2);
-    if (output_pointer == NULL)
+    index = get_index(object);
+    if ((index != NULL) && ((index->slots != NULL) || index->ambiguous))
     {
-        return false;
+        return true;
     }
-    if (output_buffer->format)
+
+    if ((index == NULL) && ((index = index_create(object, hooks)) == NULL))
     {
-        size_t i;
-        for (i = 0; i < (output_buffer->depth - 1); i++)
-        {
-            *output_pointer++ = '\t';
-        }
+        return false;
     }
-    *output_pointer++ = '}';
-    *output_pointer = '\0';
-    output_buffer->depth--;
 
-    return true;
+    return index_build_table(index, object);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_IndexObject(cJSON *object)
+{
+    return index_object(object, &global_hooks);
+}
+
+CJSON_PUBLIC(void) cJSON_InvalidateIndex(cJSON *item)
+{
+    /* the item may have been changed by hand, which the memoized hashes above it can't tell */
+    trees_changed();
+    index_drop(item);
 }
 
 /* Get Array size/item / object item. */
 CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
 {
+    const cJSON_Index *index = NULL;
     cJSON *child = NULL;
     size_t size = 0;
 
@@ -1864,6 +6360,12 @@ CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
         return 0;
     }
 
+    index = get_index(array);
+    if (index != NULL)
+    {
+        return (int)index->count;
+    }
+
     child = array->child;
 
     while(child != NULL)
@@ -1879,6 +6381,7 @@ CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
 
 static cJSON* get_array_item(const cJSON *array, size_t index)
 {
+    const cJSON_Index *array_index = NULL;
     cJSON *current_child = NULL;
 
     if (array == NULL)
@@ -1886,6 +6389,12 @@ static cJSON* get_array_item(const cJSON *array, size_t index)
         return NULL;
     }
 
+    array_index = get_index(array);
+    if ((array_index != NULL) && (array_index->items != NULL))
+    {
+        return (index < array_index->count) ? array_index->items[index] : NULL;
+    }
+
     current_child = array->child;
     while ((current_child != NULL) && (index > 0))
     {
@@ -1908,6 +6417,7 @@ CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index)
 
 static cJSON *get_object_item(const cJSON * const object, const char * const name, const cJSON_bool case_sensitive)
 {
+    const cJSON_Index *index = NULL;
     cJSON *current_element = NULL;
 
     if ((object == NULL) || (name == NULL))
@@ -1915,6 +6425,18 @@ static cJSON *get_object_item(const cJSON * const object, const char * const nam
         return NULL;
     }
 
+    index = get_object_index(object);
+    if (index != NULL)
+    {
+        current_element = index_find(index, name);
+        if (case_sensitive && (current_element != NULL) && (strcmp(name, current_element->string) != 0))
+        {
+            return NULL;
+        }
+
+        return current_element;
+    }
+
     current_element = object->child;
     if (case_sensitive)
     {
@@ -1978,12 +6500,19 @@ static cJSON *create_reference(const cJSON *item, const internal_hooks * const h
     memcpy(reference, item, sizeof(cJSON));
     reference->string = NULL;
     reference->type |= cJSON_IsReference;
+    reference->type &= ~cJSON_ArenaOwned;
     reference->next = reference->prev = NULL;
+    if (reference->type & (cJSON_Array | cJSON_Object))
+    {
+        /* the index belongs to item */
+        set_index(reference, NULL);
+    }
     return reference;
 }
 
 static cJSON_bool add_item_to_array(cJSON *array, cJSON *item)
 {
+    const cJSON_Index *index = NULL;
     cJSON *child = NULL;
 
     if ((item == NULL) || (array == NULL) || (array == item))
@@ -2012,6 +6541,9 @@ static cJSON_bool add_item_to_array(cJSON *array, cJSON *item)
         }
     }
 
+    index = get_index(array);
+    index_link(array, item, (index != NULL) ? index->count : 0);
+
     return true;
 }
 
@@ -2021,22 +6553,6 @@ CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToArray(cJSON *array, cJSON *item)
     return add_item_to_array(array, item);
 }
 
-#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
-    #pragma GCC diagnostic push
-#endif
-#ifdef __GNUC__
-#pragma GCC diagnostic ignored "-Wcast-qual"
-#endif
-/* helper function to cast away const */
-static void* cast_away_const(const void* string)
-{
-    return (void*)string;
-}
-#if defined(__clang__) || (defined(__GNUC__)  && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ > 5))))
-    #pragma GCC diagnostic pop
-#endif
-
-
 static cJSON_bool add_item_to_object(cJSON * const object, const char * const string, cJSON * const item, const internal_hooks * const hooks, const cJSON_bool constant_key)
 {
     char *new_key = NULL;
@@ -2050,7 +6566,7 @@ static cJSON_bool add_item_to_object(cJSON * const object, const char * const st
     if (constant_key)
     {
         new_key = (char*)cast_away_const(string);
-        new_type = item->type | cJSON_StringIsConst;
+        new_type = (item->type & ~cJSON_StringInPlace) | cJSON_StringIsConst;
     }
     else
     {
@@ -2060,12 +6576,12 @@ static cJSON_bool add_item_to_object(cJSON * const object, const char * const st
             return false;
         }
 
-        new_type = item->type & ~cJSON_StringIsConst;
+        new_type = item->type & ~(cJSON_StringIsConst | cJSON_StringInPlace);
     }
 
     if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
     {
-        hooks->deallocate(item->string);
+        hooks->deallocate(hooks->user_data, item->string);
     }
 
     item->string = new_key;
@@ -2242,6 +6758,8 @@ CJSON_PUBLIC(cJSON *) cJSON_DetachItemViaPointer(cJSON *parent, cJSON * const it
         parent->child->prev = item->prev;
     }
 
+    index_unlink(parent, item);
+
     /* make sure the detached item doesn't point anywhere anymore */
     item->prev = NULL;
     item->next = NULL;
@@ -2320,6 +6838,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_InsertItemInArray(cJSON *array, int which, cJSON
     {
         newitem->prev->next = newitem;
     }
+    index_link(array, newitem, (size_t)which);
     return true;
 }
 
@@ -2365,6 +6884,8 @@ CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemViaPointer(cJSON * const parent, cJSON
         }
     }
 
+    index_replace(parent, item, replacement);
+
     item->next = NULL;
     item->prev = NULL;
     cJSON_Delete(item);
@@ -2400,7 +6921,7 @@ static cJSON_bool replace_item_in_object(cJSON *object, const char *string, cJSO
         return false;
     }
 
-    replacement->type &= ~cJSON_StringIsConst;
+    replacement->type &= ~(cJSON_StringIsConst | cJSON_StringInPlace);
 
     return cJSON_ReplaceItemViaPointer(object, get_object_item(object, string, case_sensitive), replacement);
 }
@@ -2460,9 +6981,9 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateBool(cJSON_bool boolean)
     return item;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num)
+static cJSON *create_number(double num, const internal_hooks * const hooks)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    cJSON *item = cJSON_New_Item(hooks);
     if(item)
     {
         item->type = cJSON_Number;
@@ -2486,16 +7007,21 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num)
     return item;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_CreateString(const char *string)
+CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num)
 {
-    cJSON *item = cJSON_New_Item(&global_hooks);
+    return create_number(num, &global_hooks);
+}
+
+static cJSON *create_string(const char *string, const internal_hooks * const hooks)
+{
+    cJSON *item = cJSON_New_Item(hooks);
     if(item)
     {
         item->type = cJSON_String;
-        item->valuestring = (char*)cJSON_strdup((const unsigned char*)string, &global_hooks);
+        item->valuestring = (char*)cJSON_strdup((const unsigned char*)string, hooks);
         if(!item->valuestring)
         {
-            cJSON_Delete(item);
+            delete_item(item, hooks);
             return NULL;
         }
     }
@@ -2503,6 +7029,11 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateString(const char *string)
     return item;
 }
 
+CJSON_PUBLIC(cJSON *) cJSON_CreateString(const char *string)
+{
+    return create_string(string, &global_hooks);
+}
+
 CJSON_PUBLIC(cJSON *) cJSON_CreateStringReference(const char *string)
 {
     cJSON *item = cJSON_New_Item(&global_hooks);
@@ -2737,14 +7268,14 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateStringArray(const char *const *strings, int co
 }
 
 /* Duplication */
-cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse);
+cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse, const internal_hooks * const hooks);
 
 CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse)
 {
-    return cJSON_Duplicate_rec(item, 0, recurse );
+    return cJSON_Duplicate_rec(item, 0, recurse, &global_hooks);
 }
 
-cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse)
+cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse, const internal_hooks * const hooks)
 {
     cJSON *newitem = NULL;
     cJSON *child = NULL;
@@ -2757,18 +7288,18 @@ cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse)
         goto fail;
     }
     /* Create new item */
-    newitem = cJSON_New_Item(&global_hooks);
+    newitem = cJSON_New_Item(hooks);
     if (!newitem)
     {
         goto fail;
     }
     /* Copy over all vars */
-    newitem->type = item->type & (~cJSON_IsReference);
+    newitem->type = item->type & (~(cJSON_IsReference | cJSON_ArenaOwned | cJSON_StringInPlace));
     newitem->valueint = item->valueint;
     newitem->valuedouble = item->valuedouble;
-    if (item->valuestring)
+    if (item->valuestring && !(item->type & (cJSON_Array | cJSON_Object)))
     {
-        newitem->valuestring = (char*)cJSON_strdup((unsigned char*)item->valuestring, &global_hooks);
+        newitem->valuestring = (char*)cJSON_strdup((unsigned char*)item->valuestring, hooks);
         if (!newitem->valuestring)
         {
             goto fail;
@@ -2776,7 +7307,16 @@ cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse)
     }
     if (item->string)
     {
-        newitem->string = (item->type&cJSON_StringIsConst) ? item->string : (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
+        /* arena and in-place keys don't outlive their memory, so the copy needs its own */
+        if ((item->type & cJSON_StringIsConst) && !(item->type & (cJSON_ArenaOwned | cJSON_StringInPlace)))
+        {
+            newitem->string = item->string;
+        }
+        else
+        {
+            newitem->string = (char*)cJSON_strdup((unsigned char*)item->string, hooks);
+            newitem->type &= ~cJSON_StringIsConst;
+        }
         if (!newitem->string)
         {
             goto fail;
@@ -2794,7 +7334,7 @@ cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse)
         if(depth >= CJSON_CIRCULAR_LIMIT) {
             goto fail;
         }
-        newchild = cJSON_Duplicate_rec(child, depth + 1, true); /* Duplicate (with recurse) each item in the ->next chain */
+        newchild = cJSON_Duplicate_rec(child, depth + 1, true, hooks); /* Duplicate (with recurse) each item in the ->next chain */
         if (!newchild)
         {
             goto fail;
@@ -2824,210 +7364,595 @@ cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse)
 fail:
     if (newitem != NULL)
     {
-        cJSON_Delete(newitem);
+        delete_item(newitem, hooks);
     }
 
     return NULL;
 }
 
-static void skip_oneline_comment(char **input)
+#define is_minify_whitespace(character) (((character) == ' ') || ((character) == '\t') || ((character) == '\r') || ((character) == '\n'))
+
+typedef struct
+{
+    unsigned char *buffer;
+    size_t length;
+    size_t input;
+    size_t output;
+    cJSON_bool in_string;
+    cJSON_bool escaped; /* the previous byte was a backslash in a string */
+} minify_state;
+
+/* the byte at a time minifier, handles input up to stop (comments may go past it) */
+static void minify_bytes(minify_state * const state, const size_t stop)
 {
-    *input += static_strlen("//");
+    unsigned char * const buffer = state->buffer;
 
-    for (; (*input)[0] != '\0'; ++(*input))
+    while (state->input < stop)
     {
-        if ((*input)[0] == '\n') {
-            *input += static_strlen("\n");
-            return;
+        const unsigned char character = buffer[state->input];
+
+        if (state->in_string)
+        {
+            buffer[state->output++] = character;
+            state->input++;
+            if (state->escaped)
+            {
+                state->escaped = false;
+            }
+            else if (character == '\\')
+            {
+                state->escaped = true;
+            }
+            else if (character == '\"')
+            {
+                state->in_string = false;
+            }
+        }
+        else if (is_minify_whitespace(character))
+        {
+            state->input++;
+        }
+        else if (character == '/')
+        {
+            const size_t next = state->input + 1;
+            if ((next < state->length) && (buffer[next] == '/'))
+            {
+                /* one line comment, up to and including the newline */
+                const unsigned char *newline = (const unsigned char*)memchr(buffer + next, '\n', state->length - next);
+                state->input = (newline != NULL) ? (size_t)(newline - buffer) + 1 : state->length;
+            }
+            else if ((next < state->length) && (buffer[next] == '*'))
+            {
+                /* multi line comment */
+                size_t position = next + 1;
+                while (((position + 1) < state->length) && !((buffer[position] == '*') && (buffer[position + 1] == '/')))
+                {
+                    position++;
+                }
+                state->input = cjson_min(position + static_strlen("*/"), state->length);
+            }
+            else
+            {
+                state->input++;
+            }
+        }
+        else
+        {
+            buffer[state->output++] = character;
+            state->input++;
+            state->in_string = (character == '\"');
         }
     }
 }
 
-static void skip_multiline_comment(char **input)
+#if defined(CJSON_SIMD_SSE2)
+/* Minify 16 bytes at once: strings are found with a prefix xor over the quotes and whitespace outside of them is
+ * dropped. Blocks with a backslash or a slash are left to minify_bytes. Returns false if the block wasn't handled. */
+static cJSON_bool minify_block(minify_state * const state)
 {
-    *input += static_strlen("/*");
+    unsigned char * const buffer = state->buffer;
+    const __m128i chunk = _mm_loadu_si128((const __m128i*)(const void*)(buffer + state->input));
+    const unsigned int quotes = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\"')));
+    const unsigned int others = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('/'))));
+    const unsigned int whitespace = (unsigned int)_mm_movemask_epi8(_mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')))));
+    unsigned int in_string = quotes;
+    unsigned int keep = 0;
+
+    if ((others != 0) || state->escaped)
+    {
+        return false;
+    }
 
-    for (; (*input)[0] != '\0'; ++(*input))
+    /* bits from an opening quote up to (not including) the closing one */
+    in_string ^= in_string << 1;
+    in_string ^= in_string << 2;
+    in_string ^= in_string << 4;
+    in_string ^= in_string << 8;
+    if (state->in_string)
     {
-        if (((*input)[0] == '*') && ((*input)[1] == '/'))
+        in_string = ~in_string;
+    }
+    in_string &= 0xFFFF;
+    state->in_string = (in_string >> 15) & 1;
+
+    keep = ~(whitespace & ~in_string) & 0xFFFF;
+    if (keep == 0xFFFF)
+    {
+        /* the output never overtakes the input, so this only overwrites bytes that were already loaded */
+        if (state->output != state->input)
         {
-            *input += static_strlen("*/");
-            return;
+            _mm_storeu_si128((__m128i*)(void*)(buffer + state->output), chunk);
+        }
+        state->output += 16;
+    }
+    else
+    {
+        const size_t input = state->input;
+        while (keep != 0)
+        {
+            buffer[state->output++] = buffer[input + trailing_zeros(keep)];
+            keep &= keep - 1;
         }
     }
+    state->input += 16;
+
+    return true;
 }
+#endif
 
-static void minify_string(char **input, char **output) {
-    (*output)[0] = (*input)[0];
-    *input += static_strlen("\"");
-    *output += static_strlen("\"");
+CJSON_PUBLIC(size_t) cJSON_MinifyWithLength(char *json, size_t length)
+{
+    minify_state state;
 
+    if (json == NULL)
+    {
+        return 0;
+    }
 
-    for (; (*input)[0] != '\0'; (void)++(*input), ++(*output)) {
-        (*output)[0] = (*input)[0];
+    state.buffer = (unsigned char*)json;
+    state.length = length;
+    state.input = 0;
+    state.output = 0;
+    state.in_string = false;
+    state.escaped = false;
 
-        if ((*input)[0] == '\"') {
-            (*output)[0] = '\"';
-            *input += static_strlen("\"");
-            *output += static_strlen("\"");
-            return;
-        } else if (((*input)[0] == '\\') && ((*input)[1] == '\"')) {
-            (*output)[1] = (*input)[1];
-            *input += static_strlen("\"");
-            *output += static_strlen("\"");
+#if defined(CJSON_SIMD_SSE2)
+    while ((state.input + 16) <= length)
+    {
+        if (!minify_block(&state))
+        {
+            minify_bytes(&state, state.input + 16);
         }
     }
+#endif
+    minify_bytes(&state, length);
+
+    if (state.output < length)
+    {
+        state.buffer[state.output] = '\0';
+    }
+
+    return state.output;
 }
 
 CJSON_PUBLIC(void) cJSON_Minify(char *json)
 {
-    char *into = json;
-
     if (json == NULL)
     {
         return;
     }
 
-    while (json[0] != '\0')
+    cJSON_MinifyWithLength(json, strlen(json));
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_IsInvalid(const cJSON * const item)
+{
+    if (item == NULL)
     {
-        switch (json[0])
-        {
-            case ' ':
-            case '\t':
-            case '\r':
-            case '\n':
-                json++;
-                break;
+        return false;
+    }
 
-            case '/':
-                if (json[1] == '/')
-                {
-                    skip_oneline_comment(&json);
-                }
-                else if (json[1] == '*')
-                {
-                    skip_multiline_comment(&json);
-                } else {
-                    json++;
-                }
-                break;
+    return (item->type & 0xFF) == cJSON_Invalid;
+}
 
-            case '\"':
-                minify_string(&json, (char**)&into);
-                break;
+CJSON_PUBLIC(cJSON_bool) cJSON_IsFalse(const cJSON * const item)
+{
+    if (item == NULL)
+    {
+        return false;
+    }
 
-            default:
-                into[0] = json[0];
-                json++;
-                into++;
-        }
+    return (item->type & 0xFF) == cJSON_False;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_IsTrue(const cJSON * const item)
+{
+    if (item == NULL)
+    {
+        return false;
     }
 
-    /* and null-terminate. */
-    *into = '\0';
+    return (item->type & 0xff) == cJSON_True;
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_IsInvalid(const cJSON * const item)
+
+CJSON_PUBLIC(cJSON_bool) cJSON_IsBool(const cJSON * const item)
+{
+    if (item == NULL)
+    {
+        return false;
+    }
+
+    return (item->type & (cJSON_True | cJSON_False)) != 0;
+}
+CJSON_PUBLIC(cJSON_bool) cJSON_IsNull(const cJSON * const item)
+{
+    if (item == NULL)
+    {
+        return false;
+    }
+
+    return (item->type & 0xFF) == cJSON_NULL;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_IsNumber(const cJSON * const item)
+{
+    if (item == NULL)
+    {
+        return false;
+    }
+
+    return (item->type & 0xFF) == cJSON_Number;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_IsString(const cJSON * const item)
+{
+    if (item == NULL)
+    {
+        return false;
+    }
+
+    return (item->type & 0xFF) == cJSON_String;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_IsArray(const cJSON * const item)
+{
+    if (item == NULL)
+    {
+        return false;
+    }
+
+    return (item->type & 0xFF) == cJSON_Array;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_IsObject(const cJSON * const item)
+{
+    if (item == NULL)
+    {
+        return false;
+    }
+
+    return (item->type & 0xFF) == cJSON_Object;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_IsRaw(const cJSON * const item)
 {
     if (item == NULL)
     {
-        return false;
+        return false;
+    }
+
+    return (item->type & 0xFF) == cJSON_Raw;
+}
+
+/* Both hashes of a value. cJSON_Hash is exact, but cJSON_Compare considers numbers equal that are only
+ * close and, optionally, keys that differ in case. The compare hash leaves out what it can't agree on,
+ * so values that cJSON_Compare finds equal always have the same compare hash. */
+typedef struct
+{
+    cJSON_hash hash;
+    cJSON_hash compare_hash;
+    size_t nodes;
+} tree_hash;
+
+static cJSON_hash hash_mix64(cJSON_hash hash)
+{
+    /* splitmix64 finalizer */
+    hash ^= hash >> 30;
+    hash *= (cJSON_hash)CJSON_UINT64_C(0xBF58476D1CE4E5B9);
+    hash ^= hash >> 27;
+    hash *= (cJSON_hash)CJSON_UINT64_C(0x94D049BB133111EB);
+    hash ^= hash >> 31;
+
+    return hash;
+}
+
+/* FNV-1a */
+static cJSON_hash hash_bytes(const unsigned char *string, const cJSON_bool lower_case)
+{
+    cJSON_hash hash = (cJSON_hash)CJSON_UINT64_C(0xCBF29CE484222325);
+
+    for (; *string != '\0'; string++)
+    {
+        hash ^= (cJSON_hash)(lower_case ? (unsigned char)tolower(*string) : *string);
+        hash *= (cJSON_hash)CJSON_UINT64_C(0x100000001B3);
+    }
+
+    return hash;
+}
+
+static const cJSON_Index *hash_memo(const cJSON * const item)
+{
+    const cJSON_Index * const index = get_index(item);
+
+    if ((index == NULL) || !index->hashed || (index->hash_epoch != current_tree_epoch()))
+    {
+        return NULL;
+    }
+
+    return index;
+}
+
+/* Without hooks this only reads the tree and trusts the memos in it. With hooks the memos are ignored
+ * and every big enough array and object gets a new one for memo_epoch, allocated with them. */
+static void hash_tree(const cJSON * const item, tree_hash * const result, const internal_hooks * const memo_hooks, const long memo_epoch)
+{
+    const cJSON_Index *memo = NULL;
+    const cJSON_hash type = (cJSON_hash)(item->type & 0xFF);
+    const cJSON *child = NULL;
+    tree_hash child_hash;
+    cJSON_hash members = 0;
+    cJSON_hash compare_members = 0;
+    cJSON_Index *index = NULL;
+
+    if ((memo_hooks == NULL) && ((memo = hash_memo(item)) != NULL))
+    {
+        result->hash = memo->hash;
+        result->compare_hash = memo->compare_hash;
+        /* it was big enough to be memoized, so is every value containing it */
+        result->nodes = (size_t)CJSON_OBJECT_INDEX_THRESHOLD;
+        return;
+    }
+
+    result->hash = type;
+    result->compare_hash = type;
+    result->nodes = 1;
+
+    switch (item->type & 0xFF)
+    {
+        case cJSON_Number:
+        {
+            double number = (item->valuedouble == 0) ? 0.0 : item->valuedouble; /* -0 equals 0 */
+            cjson_uint64 bits = 0;
+            memcpy(&bits, &number, (sizeof(bits) < sizeof(number)) ? sizeof(bits) : sizeof(number));
+            result->hash = hash_mix64(type ^ hash_mix64((cJSON_hash)(bits ^ (bits >> 32))));
+            result->compare_hash = hash_mix64(type);
+            return;
+        }
+
+        case cJSON_String:
+        case cJSON_Raw:
+            if (item->valuestring != NULL)
+            {
+                result->hash = hash_mix64(type ^ hash_bytes((const unsigned char*)item->valuestring, false));
+            }
+            result->compare_hash = result->hash;
+            return;
+
+        case cJSON_Array:
+            cJSON_ArrayForEach(child, item)
+            {
+                hash_tree(child, &child_hash, memo_hooks, memo_epoch);
+                result->hash = hash_mix64(result->hash + child_hash.hash);
+                result->compare_hash = hash_mix64(result->compare_hash + child_hash.compare_hash);
+                result->nodes += child_hash.nodes;
+            }
+            break;
+
+        case cJSON_Object:
+            cJSON_ArrayForEach(child, item)
+            {
+                cJSON_hash key = 0;
+                cJSON_hash lower_case_key = 0;
+                if (child->string != NULL)
+                {
+                    key = hash_bytes((const unsigned char*)child->string, false);
+                    lower_case_key = hash_bytes((const unsigned char*)child->string, true);
+                }
+                hash_tree(child, &child_hash, memo_hooks, memo_epoch);
+                /* summing up the members makes their order irrelevant */
+                members += hash_mix64((key * 31) + child_hash.hash);
+                compare_members += hash_mix64((lower_case_key * 31) + child_hash.compare_hash);
+                result->nodes += child_hash.nodes;
+            }
+            result->hash = hash_mix64(type ^ members);
+            result->compare_hash = hash_mix64(type ^ compare_members);
+            break;
+
+        default:
+            result->hash = hash_mix64(type);
+            result->compare_hash = result->hash;
+            return;
+    }
+
+    /* memoize the hash of big arrays and objects, references and arena nodes can't keep an index */
+    if ((memo_hooks == NULL) || (result->nodes < (size_t)CJSON_OBJECT_INDEX_THRESHOLD) || (item->type & (cJSON_IsReference | cJSON_ArenaOwned)))
+    {
+        return;
     }
 
-    return (item->type & 0xFF) == cJSON_Invalid;
+    /* only cJSON_MemoizeHash passes hooks, and it got item as non const */
+    index = get_index(item);
+    if ((index == NULL) && ((index = index_create((cJSON*)cast_away_const(item), memo_hooks)) == NULL))
+    {
+        return;
+    }
+    index->hash = result->hash;
+    index->compare_hash = result->compare_hash;
+    index->hash_epoch = memo_epoch;
+    index->hashed = true;
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_IsFalse(const cJSON * const item)
+CJSON_PUBLIC(cJSON_hash) cJSON_Hash(const cJSON *item)
 {
+    tree_hash result;
+
     if (item == NULL)
     {
-        return false;
+        return 0;
     }
 
-    return (item->type & 0xFF) == cJSON_False;
+    hash_tree(item, &result, NULL, 0);
+
+    return result.hash;
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_IsTrue(const cJSON * const item)
+static cJSON_hash memoize_hash(cJSON * const item, const internal_hooks * const hooks)
 {
+    tree_hash result;
+
     if (item == NULL)
     {
-        return false;
+        return 0;
     }
 
-    return (item->type & 0xff) == cJSON_True;
-}
+#if defined(CJSON_HASH_MEMOS)
+    /* changes from now on are counted, one that happens while hashing only makes the memos stale */
+    atomic_set(hashes_memoized);
+    hash_tree(item, &result, hooks, current_tree_epoch());
+#else
+    (void)hooks;
+    hash_tree(item, &result, NULL, 0);
+#endif
 
+    return result.hash;
+}
 
-CJSON_PUBLIC(cJSON_bool) cJSON_IsBool(const cJSON * const item)
+CJSON_PUBLIC(cJSON_hash) cJSON_MemoizeHash(cJSON *item)
 {
-    if (item == NULL)
-    {
-        return false;
-    }
-
-    return (item->type & (cJSON_True | cJSON_False)) != 0;
+    return memoize_hash(item, &global_hooks);
 }
-CJSON_PUBLIC(cJSON_bool) cJSON_IsNull(const cJSON * const item)
+
+/* Only looks at memoized hashes, computing them would cost as much as comparing. */
+static cJSON_bool memoized_hashes_differ(const cJSON * const a, const cJSON * const b)
 {
-    if (item == NULL)
-    {
-        return false;
-    }
+    const cJSON_Index * const a_memo = hash_memo(a);
+    const cJSON_Index * const b_memo = hash_memo(b);
 
-    return (item->type & 0xFF) == cJSON_NULL;
+    return (a_memo != NULL) && (b_memo != NULL) && (a_memo->compare_hash != b_memo->compare_hash);
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_IsNumber(const cJSON * const item)
+static size_t count_children(const cJSON * const item)
 {
-    if (item == NULL)
+    const cJSON_Index * const index = get_index(item);
+    const cJSON *child = NULL;
+    size_t count = 0;
+
+    if (index != NULL)
     {
-        return false;
+        return index->count;
     }
 
-    return (item->type & 0xFF) == cJSON_Number;
-}
-
-CJSON_PUBLIC(cJSON_bool) cJSON_IsString(const cJSON * const item)
-{
-    if (item == NULL)
+    for (child = item->child; child != NULL; child = child->next)
     {
-        return false;
+        count++;
     }
 
-    return (item->type & 0xFF) == cJSON_String;
+    return count;
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_IsArray(const cJSON * const item)
+static cJSON_bool compare_items(const cJSON * const a, const cJSON * const b, const cJSON_bool case_sensitive, const internal_hooks * const hooks);
+
+/* Compares the members of two objects with the same number of members in linear time. The members
+ * of b are looked up in the hash index of a, or in a temporary table if a has none, and every member
+ * of a has to be matched exactly once. Returns -1 if a has keys that only differ in case or memory
+ * runs out, the caller falls back to searching both lists then. Scratch memory comes from hooks. */
+static int compare_object_members(const cJSON * const a, const cJSON * const b, const size_t count, const cJSON_bool case_sensitive, const internal_hooks * const hooks)
 {
-    if (item == NULL)
+    cJSON_Index table;
+    const cJSON_Index *index = get_object_index(a);
+    unsigned char *matched = NULL;
+    cJSON *element = NULL;
+    int result = -1;
+
+    memset(&table, '\0', sizeof(table));
+    table.hooks = hooks;
+    if (index == NULL)
     {
-        return false;
+        if (!index_resize(&table, count))
+        {
+            return -1;
+        }
+        for (element = a->child; (element != NULL) && !table.ambiguous; element = element->next)
+        {
+            if (element->string == NULL)
+            {
+                result = 0;
+                goto cleanup;
+            }
+            index_insert(&table, element, hash_key((const unsigned char*)element->string));
+        }
+        if (table.ambiguous)
+        {
+            goto cleanup;
+        }
+        index = &table;
     }
 
-    return (item->type & 0xFF) == cJSON_Array;
-}
-
-CJSON_PUBLIC(cJSON_bool) cJSON_IsObject(const cJSON * const item)
-{
-    if (item == NULL)
+    matched = (unsigned char*)hooks->allocate(hooks->user_data, index->capacity);
+    if (matched == NULL)
     {
-        return false;
+        goto cleanup;
     }
+    memset(matched, '\0', index->capacity);
 
-    return (item->type & 0xFF) == cJSON_Object;
-}
+    result = 1;
+    cJSON_ArrayForEach(element, b)
+    {
+        const index_slot *slot = NULL;
+        size_t position = 0;
 
-CJSON_PUBLIC(cJSON_bool) cJSON_IsRaw(const cJSON * const item)
-{
-    if (item == NULL)
+        if (element->string == NULL)
+        {
+            result = 0;
+            break;
+        }
+        slot = index_find_slot(index, element->string);
+        if ((slot == NULL) || (case_sensitive && (strcmp(element->string, slot->item->string) != 0)))
+        {
+            result = 0;
+            break;
+        }
+
+        /* a second member of b with the same key leaves a member of a without a partner */
+        position = (size_t)(slot - index->slots);
+        if (matched[position])
+        {
+            result = 0;
+            break;
+        }
+        matched[position] = 1;
+
+        if (!compare_items(slot->item, element, case_sensitive, hooks))
+        {
+            result = 0;
+            break;
+        }
+    }
+
+cleanup:
+    if (matched != NULL)
     {
-        return false;
+        hooks->deallocate(hooks->user_data, matched);
     }
+    index_drop_table(&table);
 
-    return (item->type & 0xFF) == cJSON_Raw;
+    return result;
 }
 
-CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * const b, const cJSON_bool case_sensitive)
+static cJSON_bool compare_items(const cJSON * const a, const cJSON * const b, const cJSON_bool case_sensitive, const internal_hooks * const hooks)
 {
     if ((a == NULL) || (b == NULL) || ((a->type & 0xFF) != (b->type & 0xFF)))
     {
@@ -3057,6 +7982,12 @@ CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * cons
         return true;
     }
 
+    /* arrays and objects that were hashed before can be told apart right away */
+    if (memoized_hashes_differ(a, b))
+    {
+        return false;
+    }
+
     switch (a->type & 0xFF)
     {
         /* in these cases and equal type is enough */
@@ -3092,7 +8023,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * cons
 
             for (; (a_element != NULL) && (b_element != NULL);)
             {
-                if (!cJSON_Compare(a_element, b_element, case_sensitive))
+                if (!compare_items(a_element, b_element, case_sensitive, hooks))
                 {
                     return false;
                 }
@@ -3113,23 +8044,40 @@ CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * cons
         {
             cJSON *a_element = NULL;
             cJSON *b_element = NULL;
+            const size_t count = count_children(a);
+
+            /* objects with a different number of members can't be equal */
+            if (count != count_children(b))
+            {
+                return false;
+            }
+
+            if (count >= (size_t)CJSON_OBJECT_INDEX_THRESHOLD)
+            {
+                const int result = compare_object_members(a, b, count, case_sensitive, hooks);
+                if (result >= 0)
+                {
+                    return result ? true : false;
+                }
+            }
+
+            /* small objects, or keys that differ only in case: search the other list for every member */
             cJSON_ArrayForEach(a_element, a)
             {
-                /* TODO This has O(n^2) runtime, which is horrible! */
                 b_element = get_object_item(b, a_element->string, case_sensitive);
                 if (b_element == NULL)
                 {
                     return false;
                 }
 
-                if (!cJSON_Compare(a_element, b_element, case_sensitive))
+                if (!compare_items(a_element, b_element, case_sensitive, hooks))
                 {
                     return false;
                 }
             }
 
-            /* doing this twice, once on a and b to prevent true comparison if a subset of b
-             * TODO: Do this the proper way, this is just a fix for now */
+            /* doing this twice, once on a and b, because with duplicate keys equal member counts
+             * don't rule out that a only covers a part of b */
             cJSON_ArrayForEach(b_element, b)
             {
                 a_element = get_object_item(a, b_element->string, case_sensitive);
@@ -3138,7 +8086,7 @@ CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * cons
                     return false;
                 }
 
-                if (!cJSON_Compare(b_element, a_element, case_sensitive))
+                if (!compare_items(b_element, a_element, case_sensitive, hooks))
                 {
                     return false;
                 }
@@ -3152,13 +8100,241 @@ CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * cons
     }
 }
 
+CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * const b, const cJSON_bool case_sensitive)
+{
+    return compare_items(a, b, case_sensitive, &global_hooks);
+}
+
 CJSON_PUBLIC(void *) cJSON_malloc(size_t size)
 {
-    return global_hooks.allocate(size);
+    return global_hooks.allocate(global_hooks.user_data, size);
 }
 
 CJSON_PUBLIC(void) cJSON_free(void *object)
 {
-    global_hooks.deallocate(object);
+    global_hooks.deallocate(global_hooks.user_data, object);
     object = NULL;
 }
+
+/* A context is just a set of hooks, everything made through it is allocated with them. */
+struct cJSON_Context
+{
+    internal_hooks hooks;
+    cJSON_Slab slab;
+};
+
+CJSON_PUBLIC(cJSON_Context *) cJSON_Context_New(const cJSON_ContextHooks *hooks)
+{
+    cJSON_Context *context = NULL;
+
+    if ((hooks == NULL) || (hooks->allocate == NULL) || (hooks->deallocate == NULL))
+    {
+        return NULL;
+    }
+
+    context = (cJSON_Context*)hooks->allocate(hooks->user_data, sizeof(cJSON_Context));
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    context->hooks.allocate = hooks->allocate;
+    context->hooks.deallocate = hooks->deallocate;
+    context->hooks.reallocate = hooks->reallocate;
+    context->hooks.user_data = hooks->user_data;
+    context->hooks.slab = NULL;
+    memset(&context->slab, '\0', sizeof(cJSON_Slab));
+
+    return context;
+}
+
+CJSON_PUBLIC(void) cJSON_Context_Delete(cJSON_Context *context)
+{
+    if (context != NULL)
+    {
+        slab_release(&context->slab, &context->hooks);
+        context->hooks.deallocate(context->hooks.user_data, context);
+    }
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_Context_EnableNodeSlab(cJSON_Context *context, size_t nodes_per_page)
+{
+    if (context == NULL)
+    {
+        return false;
+    }
+
+    return slab_enable(&context->hooks, &context->slab, nodes_per_page);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_Context_DisableNodeSlab(cJSON_Context *context)
+{
+    if (context == NULL)
+    {
+        return false;
+    }
+
+    return slab_disable(&context->hooks, &context->slab);
+}
+
+CJSON_PUBLIC(void) cJSON_Context_GetNodeSlabStats(const cJSON_Context *context, cJSON_SlabStats *stats)
+{
+    if (context != NULL)
+    {
+        slab_stats(&context->slab, stats);
+    }
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_Context_Parse(cJSON_Context *context, const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    return parse_document(value, buffer_length, return_parse_end, require_null_terminated, NULL, NULL, &context->hooks, &global_error);
+}
+
+CJSON_PUBLIC(char *) cJSON_Context_Print(cJSON_Context *context, const cJSON *item, cJSON_bool format)
+{
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    return (char*)print(item, format, &context->hooks);
+}
+
+CJSON_PUBLIC(void) cJSON_Context_Free(cJSON_Context *context, void *object)
+{
+    if ((context != NULL) && (object != NULL))
+    {
+        context->hooks.deallocate(context->hooks.user_data, object);
+    }
+}
+
+static cJSON *context_create(cJSON_Context * const context, const int type)
+{
+    cJSON *item = NULL;
+
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    item = cJSON_New_Item(&context->hooks);
+    if (item != NULL)
+    {
+        item->type = type;
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_Context_CreateNull(cJSON_Context *context)
+{
+    return context_create(context, cJSON_NULL);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_Context_CreateBool(cJSON_Context *context, cJSON_bool boolean)
+{
+    return context_create(context, boolean ? cJSON_True : cJSON_False);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_Context_CreateNumber(cJSON_Context *context, double num)
+{
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    return create_number(num, &context->hooks);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_Context_CreateString(cJSON_Context *context, const char *string)
+{
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    return create_string(string, &context->hooks);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_Context_CreateArray(cJSON_Context *context)
+{
+    return context_create(context, cJSON_Array);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_Context_CreateObject(cJSON_Context *context)
+{
+    return context_create(context, cJSON_Object);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_Context_AddItemToObject(cJSON_Context *context, cJSON *object, const char *string, cJSON *item)
+{
+    if (context == NULL)
+    {
+        return false;
+    }
+
+    return add_item_to_object(object, string, item, &context->hooks, false);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_Context_Duplicate(cJSON_Context *context, const cJSON *item, cJSON_bool recurse)
+{
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    return cJSON_Duplicate_rec(item, 0, recurse, &context->hooks);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_Context_IndexArray(cJSON_Context *context, cJSON *array)
+{
+    if (context == NULL)
+    {
+        return false;
+    }
+
+    return index_array(array, &context->hooks);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_Context_IndexObject(cJSON_Context *context, cJSON *object)
+{
+    if (context == NULL)
+    {
+        return false;
+    }
+
+    return index_object(object, &context->hooks);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_Context_Compare(cJSON_Context *context, const cJSON *a, const cJSON *b, cJSON_bool case_sensitive)
+{
+    if (context == NULL)
+    {
+        return false;
+    }
+
+    return compare_items(a, b, case_sensitive, &context->hooks);
+}
+
+CJSON_PUBLIC(cJSON_hash) cJSON_Context_MemoizeHash(cJSON_Context *context, cJSON *item)
+{
+    if (context == NULL)
+    {
+        return 0;
+    }
+
+    return memoize_hash(item, &context->hooks);
+}
+
+CJSON_PUBLIC(void) cJSON_Context_DeleteItem(cJSON_Context *context, cJSON *item)
+{
+    if (context != NULL)
+    {
+        delete_item(item, &context->hooks);
+    }
+}
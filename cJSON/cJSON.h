@@ -80,10 +80,11 @@ then using the CJSON_API_VISIBILITY flag to "export" the same symbols the way CJ
 
 /* project version */
 #define CJSON_VERSION_MAJOR 1
-#define CJSON_VERSION_MINOR 7
-#define CJSON_VERSION_PATCH 18
+#define CJSON_VERSION_MINOR 8
+#define CJSON_VERSION_PATCH 0
 
 #include <stddef.h>
+#include <limits.h>
 
 /* cJSON Types: */
 #define cJSON_Invalid (0)
@@ -98,6 +99,8 @@ then using the CJSON_API_VISIBILITY flag to "export" the same symbols the way CJ
 
 #define cJSON_IsReference 256
 #define cJSON_StringIsConst 512
+#define cJSON_ArenaOwned 1024 /* the item itself lives in a cJSON_Arena and is not freed by cJSON_Delete */
+#define cJSON_StringInPlace 4096 /* the const key points into the buffer given to cJSON_ParseInPlace */
 
 /* The cJSON structure: */
 typedef struct cJSON
@@ -111,7 +114,8 @@ typedef struct cJSON
     /* The type of the item, as above. */
     int type;
 
-    /* The item's string, if type==cJSON_String  and type == cJSON_Raw */
+    /* The item's string, if type==cJSON_String  and type == cJSON_Raw.
+     * Arrays and objects keep their lookup index here (see cJSON_IndexObject), it belongs to cJSON. */
     char *valuestring;
     /* writing to valueint is DEPRECATED, use cJSON_SetNumberValue instead */
     int valueint;
@@ -131,6 +135,116 @@ typedef struct cJSON_Hooks
 
 typedef int cJSON_bool;
 
+/* Hash of cJSON_Hash, 64 bits wide wherever the compiler has such a type (C89 doesn't require one). */
+#if ULONG_MAX > 0xFFFFFFFFUL
+typedef unsigned long cJSON_hash;
+#elif defined(_MSC_VER)
+typedef unsigned __int64 cJSON_hash;
+#elif (defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 199901L)) || (defined(__cplusplus) && (__cplusplus >= 201103L))
+typedef unsigned long long cJSON_hash;
+#elif defined(__GNUC__)
+__extension__ typedef unsigned long long cJSON_hash;
+#else
+typedef unsigned long cJSON_hash;
+#endif
+
+/* Region allocator for cJSON_ParseArena. Initialize with cJSON_ArenaInit (or zero it).
+ * Memory is taken in blocks from the global hooks and is only given back by cJSON_ArenaFree. */
+typedef struct cJSON_Arena
+{
+    struct cJSON_ArenaBlock *blocks; /* chain of blocks owned by the arena */
+    struct cJSON_ArenaBlock *current; /* block that allocations are currently served from */
+    size_t block_size; /* size of the first block, later blocks double in size */
+} cJSON_Arena;
+
+/* Event handler for cJSON_ParseSax. Every callback is optional, returning false from one aborts the parse.
+ * Strings and keys are decoded and zero terminated, but only valid until the callback returns. */
+typedef struct cJSON_SaxHandler
+{
+    cJSON_bool (*null_value)(void *user_data);
+    cJSON_bool (*boolean)(void *user_data, cJSON_bool value);
+    cJSON_bool (*number)(void *user_data, double value);
+    cJSON_bool (*string)(void *user_data, const char *value);
+    /* name of the object member whose value comes next */
+    cJSON_bool (*key)(void *user_data, const char *key);
+    cJSON_bool (*start_object)(void *user_data);
+    cJSON_bool (*end_object)(void *user_data);
+    cJSON_bool (*start_array)(void *user_data);
+    cJSON_bool (*end_array)(void *user_data);
+} cJSON_SaxHandler;
+
+/* Why a parse failed, see cJSON_ParseWithError. */
+#define cJSON_ParseErrorNone 0
+#define cJSON_ParseErrorNoInput 1
+#define cJSON_ParseErrorOutOfMemory 2
+#define cJSON_ParseErrorUnexpectedEnd 3
+#define cJSON_ParseErrorUnexpectedCharacter 4
+#define cJSON_ParseErrorInvalidString 5 /* bad escape sequence */
+#define cJSON_ParseErrorInvalidNumber 6
+#define cJSON_ParseErrorTooDeep 7 /* more than CJSON_NESTING_LIMIT */
+#define cJSON_ParseErrorTrailingData 8 /* something other than whitespace after the document */
+
+typedef struct cJSON_ParseError
+{
+    size_t offset; /* of the error in the input, like cJSON_GetErrorPtr */
+    size_t line; /* starting at 1 */
+    size_t column; /* in bytes, starting at 1 */
+    int reason; /* cJSON_ParseError... */
+} cJSON_ParseError;
+
+/* Incremental parser state, see cJSON_StreamParser_New. */
+typedef struct cJSON_StreamParser cJSON_StreamParser;
+
+/* Allocator of a cJSON_Context. Each function gets user_data as its first argument, reallocate is optional. */
+typedef struct cJSON_ContextHooks
+{
+    void *(CJSON_CDECL *allocate)(void *user_data, size_t size);
+    void (CJSON_CDECL *deallocate)(void *user_data, void *pointer);
+    void *(CJSON_CDECL *reallocate)(void *user_data, void *pointer, size_t size);
+    void *user_data;
+} cJSON_ContextHooks;
+
+/* Allocation context, see cJSON_Context_New. */
+typedef struct cJSON_Context cJSON_Context;
+
+/* State of a node slab, see cJSON_EnableNodeSlab. */
+typedef struct cJSON_SlabStats
+{
+    size_t nodes_per_page; /* of pages that are added from now on */
+    size_t pages;
+    size_t nodes_in_use;
+    size_t nodes_free; /* in the pages, ready to be reused */
+    size_t bytes; /* taken from the allocator for the pages and the table of pages */
+} cJSON_SlabStats;
+
+/* Read-only document made by cJSON_ParseTape: every value is one 16 byte entry of a single array,
+ * in document order. An array entry is followed by its elements, an object entry by a cJSON_TapeKey
+ * entry and the value for each member. */
+#define cJSON_TapeKey 2048
+
+typedef struct cJSON_TapeEntry
+{
+    /* cJSON_False ... cJSON_Object, or cJSON_TapeKey */
+    int type;
+    /* number of entries taken by this value including its elements/members, entry + size is the entry after it */
+    unsigned int size;
+    union
+    {
+        double number; /* cJSON_Number */
+        const char *string; /* cJSON_String and cJSON_TapeKey */
+        size_t count; /* number of elements/members of cJSON_Array and cJSON_Object */
+    } value;
+} cJSON_TapeEntry;
+
+typedef struct cJSON_Tape
+{
+    /* entries[0] is the root value */
+    cJSON_TapeEntry *entries;
+    size_t length;
+    size_t capacity;
+    cJSON_Arena strings; /* decoded strings and keys */
+} cJSON_Tape;
+
 /* Limits how deeply nested arrays/objects can be before cJSON rejects to parse them.
  * This is to prevent stack overflows. */
 #ifndef CJSON_NESTING_LIMIT
@@ -143,6 +257,13 @@ typedef int cJSON_bool;
 #define CJSON_CIRCULAR_LIMIT 10000
 #endif
 
+/* cJSON_Compare matches the members of objects with at least this many members through a temporary
+ * hash table instead of searching the other object for each of them, and cJSON_MemoizeHash keeps the
+ * hash of arrays and objects with at least this many nodes. */
+#ifndef CJSON_OBJECT_INDEX_THRESHOLD
+#define CJSON_OBJECT_INDEX_THRESHOLD 16
+#endif
+
 /* returns the version of cJSON as a string */
 CJSON_PUBLIC(const char*) cJSON_Version(void);
 
@@ -157,6 +278,81 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error so will match cJSON_GetErrorPtr(). */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* Like cJSON_ParseWithLengthOpts, but a failure is described in parse_error (if not NULL) instead of the
+ * error that cJSON_GetErrorPtr reports, which makes it safe to parse on several threads at once. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithError(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, cJSON_ParseError *parse_error);
+/* A short English description of a cJSON_ParseError reason. */
+CJSON_PUBLIC(const char *) cJSON_GetParseErrorMessage(int reason);
+
+/* Arena parsing: all nodes, keys and strings of the tree are bump-allocated from the arena and are released
+ * together by cJSON_ArenaReset or cJSON_ArenaFree, which invalidates every tree parsed into that arena.
+ * Passing such a tree to cJSON_Delete is harmless (items added later with the normal API are freed), but it is not needed.
+ * Keys are flagged cJSON_StringIsConst and string values cJSON_IsReference, so cJSON_SetValuestring refuses to change them. */
+CJSON_PUBLIC(void) cJSON_ArenaInit(cJSON_Arena *arena, size_t block_size);
+CJSON_PUBLIC(cJSON *) cJSON_ParseArena(const char *value, size_t buffer_length, cJSON_Arena *arena);
+/* Makes all memory of the arena available again without returning it to the allocator. O(1). */
+CJSON_PUBLIC(void) cJSON_ArenaReset(cJSON_Arena *arena);
+/* Returns all blocks of the arena to the allocator. */
+CJSON_PUBLIC(void) cJSON_ArenaFree(cJSON_Arena *arena);
+
+/* In-place parsing: keys and string values without escape sequences are not copied, their closing quote in value
+ * is overwritten with '\0' and the item points into value, which has to outlive the tree. Such values are flagged
+ * cJSON_IsReference and such keys cJSON_StringIsConst | cJSON_StringInPlace. cJSON_Duplicate copies both, so
+ * duplicates don't depend on value. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseInPlace(char *value, size_t buffer_length);
+
+/* Two stage parsing for large documents: an index of the structural characters is built first, then the tree
+ * is built from it without reading the whitespace in between. Same results and error reporting as
+ * cJSON_ParseWithLengthOpts, but an invalid document is read twice to find the error. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseFast(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+
+/* Newline delimited JSON: every line of value holds one document, blank lines are skipped. If cJSON was built with
+ * CJSON_ENABLE_THREADS, lines are parsed on up to threads threads (0 for one per processor), otherwise all of them
+ * on the calling thread. The workers allocate at the same time through the hooks given to cJSON_InitHooks, so those
+ * have to be thread safe. callback is called on the calling thread, once per document and in input order. It takes
+ * ownership of item and can stop the parse by returning false.
+ * Returns false if a line is invalid, cJSON_GetErrorPtr then points to the error. */
+CJSON_PUBLIC(cJSON_bool) cJSON_ParseLines(const char *value, size_t buffer_length, int threads, cJSON_bool (*callback)(void *user_data, cJSON *item), void *user_data);
+/* Collects the documents of cJSON_ParseLines into an array, NULL if any line is invalid. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseLinesToArray(const char *value, size_t buffer_length, int threads);
+
+/* Event parsing: reports the document to handler as it is read, without building a tree. Accepts the same documents
+ * as cJSON_ParseWithLength and reports errors the same way, including when a callback aborts (cJSON_GetErrorPtr then
+ * points behind the rejected value). Returns true on success. */
+CJSON_PUBLIC(cJSON_bool) cJSON_ParseSax(const char *value, size_t buffer_length, const cJSON_SaxHandler *handler, void *user_data);
+
+/* Tape parsing: builds a cJSON_Tape instead of a tree, with the same validation and error reporting as
+ * cJSON_ParseWithLength. Only two allocations grow with the document, one for the entries and one for
+ * the strings. Free it with cJSON_DeleteTape. */
+CJSON_PUBLIC(cJSON_Tape *) cJSON_ParseTape(const char *value, size_t buffer_length);
+CJSON_PUBLIC(void) cJSON_DeleteTape(cJSON_Tape *tape);
+/* Accessors for tape entries, they work like their cJSON counterparts. */
+CJSON_PUBLIC(int) cJSON_TapeGetArraySize(const cJSON_TapeEntry *array);
+CJSON_PUBLIC(const cJSON_TapeEntry *) cJSON_TapeGetArrayItem(const cJSON_TapeEntry *array, int index);
+CJSON_PUBLIC(const cJSON_TapeEntry *) cJSON_TapeGetObjectItem(const cJSON_TapeEntry *object, const char *string);
+CJSON_PUBLIC(const cJSON_TapeEntry *) cJSON_TapeGetObjectItemCaseSensitive(const cJSON_TapeEntry *object, const char *string);
+/* First element/member value of an array/object and the one following element, NULL at the end. */
+CJSON_PUBLIC(const cJSON_TapeEntry *) cJSON_TapeChild(const cJSON_TapeEntry *container);
+CJSON_PUBLIC(const cJSON_TapeEntry *) cJSON_TapeNext(const cJSON_TapeEntry *container, const cJSON_TapeEntry *element);
+/* The key of an object member, given its value entry, NULL if the entry before member isn't a key.
+ * Pass a value of object itself, for a value nested deeper this returns its key in its own object. */
+CJSON_PUBLIC(const char *) cJSON_TapeGetKey(const cJSON_TapeEntry *object, const cJSON_TapeEntry *member);
+CJSON_PUBLIC(const char *) cJSON_TapeGetStringValue(const cJSON_TapeEntry *item);
+CJSON_PUBLIC(double) cJSON_TapeGetNumberValue(const cJSON_TapeEntry *item);
+
+/* Incremental parsing of a document that arrives in chunks. Each call to cJSON_StreamParser_Feed
+ * consumes the whole chunk and reports the values that are complete so far, the parser keeps its state
+ * between calls. With a handler the values are reported as events like in cJSON_ParseSax, without one
+ * (NULL) a tree is built. Feed and Finish return false once the input is invalid. */
+CJSON_PUBLIC(cJSON_StreamParser *) cJSON_StreamParser_New(const cJSON_SaxHandler *handler, void *user_data);
+CJSON_PUBLIC(cJSON_bool) cJSON_StreamParser_Feed(cJSON_StreamParser *parser, const char *chunk, size_t length);
+/* Call at the end of the input, succeeds if it held a complete document. */
+CJSON_PUBLIC(cJSON_bool) cJSON_StreamParser_Finish(cJSON_StreamParser *parser);
+/* Take the tree out of a finished parser, the caller has to delete it. */
+CJSON_PUBLIC(cJSON *) cJSON_StreamParser_DetachTree(cJSON_StreamParser *parser);
+/* Offset in the whole stream of the byte where the input stopped being valid, 0 if there was no error. */
+CJSON_PUBLIC(size_t) cJSON_StreamParser_GetErrorOffset(const cJSON_StreamParser *parser);
+CJSON_PUBLIC(void) cJSON_StreamParser_Delete(cJSON_StreamParser *parser);
 
 /* Render a cJSON entity to text for transfer/storage. */
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
@@ -164,10 +360,19 @@ CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
 CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item);
 /* Render a cJSON entity to text using a buffered strategy. prebuffer is a guess at the final size. guessing well reduces reallocation. fmt=0 gives unformatted, =1 gives formatted */
 CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt);
+/* Render a cJSON entity to text piece by piece: whenever the internal buffer of CJSON_SINK_BUFFER_SIZE bytes is full,
+ * its contents are passed to write_fn (which returns false to abort). The buffer only grows for a single string or
+ * number that doesn't fit into it. The text is not zero terminated. Returns 1 if everything was written. */
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintToSink(const cJSON *item, cJSON_bool format, cJSON_bool (*write_fn)(void *context, const char *data, size_t length), void *context);
+/* Length of the text that cJSON_Print (format=1) or cJSON_PrintUnformatted would return, without the terminating zero.
+ * Works by printing into a small buffer that is reused, returns 0 if the item can't be printed. */
+CJSON_PUBLIC(size_t) cJSON_PrintedLength(const cJSON *item, cJSON_bool format);
+/* Like cJSON_Print/cJSON_PrintUnformatted, but measures with cJSON_PrintedLength first and then allocates and writes the text exactly once. */
+CJSON_PUBLIC(char *) cJSON_PrintExact(const cJSON *item, cJSON_bool format);
 /* Render a cJSON entity to text using a buffer already allocated in memory with given length. Returns 1 on success and 0 on failure. */
-/* NOTE: cJSON is not always 100% accurate in estimating how much memory it will use, so to be safe allocate 5 bytes more than you actually need */
+/* NOTE: cJSON_PrintedLength(item, format) + 1 bytes are always enough */
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format);
-/* Delete a cJSON entity and all subentities. */
+/* Delete a cJSON entity and all subentities. This doesn't recurse, so the nesting depth of the tree doesn't matter. */
 CJSON_PUBLIC(void) cJSON_Delete(cJSON *item);
 
 /* Returns the number of items in an array (or object). */
@@ -178,7 +383,21 @@ CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON_bool) cJSON_HasObjectItem(const cJSON *object, const char *string);
-/* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. */
+/* Builds an index for an array so cJSON_GetArrayItem and cJSON_GetArraySize are O(1) for as long as the
+ * array lives. Returns false if out of memory or for arena and reference arrays, which can't have one. */
+CJSON_PUBLIC(cJSON_bool) cJSON_IndexArray(cJSON *array);
+/* Builds a hash index for an object so cJSON_GetObjectItem and friends are O(1) for as long as the
+ * object lives. Lookups never build one themselves, they only read the tree, so a tree that isn't changed
+ * can be searched on several threads at once. An object with duplicate keys (or keys that only differ in case)
+ * is searched linearly until they are gone. Returns false if out of memory or for arena and reference objects. */
+CJSON_PUBLIC(cJSON_bool) cJSON_IndexObject(cJSON *object);
+/* Drops the lookup index of an array/object. Only needed after relinking item->child by hand, renaming
+ * a member's string in place or before changing the type of the item by hand (the index is kept in its
+ * valuestring); the cJSON functions keep the index up to date.
+ * Also forgets the hashes memoized by cJSON_MemoizeHash, call it after writing any field by hand. */
+CJSON_PUBLIC(void) cJSON_InvalidateIndex(cJSON *item);
+/* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds.
+ * The error is kept per thread if the compiler supports thread local storage. */
 CJSON_PUBLIC(const char *) cJSON_GetErrorPtr(void);
 
 /* Check item type and return its value */
@@ -256,6 +475,17 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse);
 /* Duplicate will create a new, identical cJSON item to the one you pass, in new memory that will
  * need to be released. With recurse!=0, it will duplicate any children connected to the item.
  * The item->next and ->prev pointers are always zero on return from Duplicate. */
+/* Returns a hash of the value of item: equal values hash the same, the order of the members of an object
+ * doesn't matter but the order of array elements does. The key of item itself isn't part of it. This only
+ * reads the tree, it uses the hashes memoized by cJSON_MemoizeHash but never stores any. */
+CJSON_PUBLIC(cJSON_hash) cJSON_Hash(const cJSON *item);
+/* Like cJSON_Hash, but ignores old memos and memoizes the hash of item and of every array and object in it
+ * with at least CJSON_OBJECT_INDEX_THRESHOLD nodes. That speeds up later hashes and lets cJSON_Compare tell
+ * memoized values apart right away. Every change made through the cJSON functions (including
+ * cJSON_SetValuestring and cJSON_SetNumberValue) forgets all memos. Fields written by hand, which includes
+ * the cJSON_SetIntValue and cJSON_SetBoolValue macros, need a cJSON_InvalidateIndex call afterwards.
+ * Memos need atomics (GCC, clang or MSVC), other compilers only compute the hash. */
+CJSON_PUBLIC(cJSON_hash) cJSON_MemoizeHash(cJSON *item);
 /* Recursively compare two cJSON items for equality. If either a or b is NULL or invalid, they will be considered unequal.
  * case_sensitive determines if object keys are treated case sensitive (1) or case insensitive (0) */
 CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * const b, const cJSON_bool case_sensitive);
@@ -264,6 +494,9 @@ CJSON_PUBLIC(cJSON_bool) cJSON_Compare(const cJSON * const a, const cJSON * cons
  * The input pointer json cannot point to a read-only address area, such as a string constant, 
  * but should point to a readable and writable address area. */
 CJSON_PUBLIC(void) cJSON_Minify(char *json);
+/* Minify the first length bytes of json in place, without relying on a terminating zero. Returns the new length,
+ * the result is zero terminated if it is shorter than length. */
+CJSON_PUBLIC(size_t) cJSON_MinifyWithLength(char *json, size_t length);
 
 /* Helper functions for creating and adding items to an object at the same time.
  * They return the added item or NULL on failure. */
@@ -294,11 +527,61 @@ CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
 
 /* Macro for iterating over an array or object */
 #define cJSON_ArrayForEach(element, array) for(element = (array != NULL) ? (array)->child : NULL; element != NULL; element = element->next)
+/* Macro for iterating over a tape array or object, element is a const cJSON_TapeEntry * */
+#define cJSON_TapeArrayForEach(element, array) for(element = cJSON_TapeChild(array); element != NULL; element = cJSON_TapeNext(array, element))
 
 /* malloc/free objects using the malloc/free functions that have been set with cJSON_InitHooks */
 CJSON_PUBLIC(void *) cJSON_malloc(size_t size);
 CJSON_PUBLIC(void) cJSON_free(void *object);
 
+/* Node slab: while it is enabled, nodes are allocated in pages of nodes_per_page nodes (0 for the default of
+ * CJSON_SLAB_PAGE_NODES) and deleted nodes are kept for reuse instead of being freed. Only keys, strings and
+ * whole pages go through the allocator. cJSON_Delete tells slab nodes apart by their address, so nodes
+ * made before the slab was enabled are still freed through the allocator. Disabling
+ * fails while slab nodes are in use and otherwise frees the pages. The global slab is not thread safe, only use
+ * it when one thread at a time uses cJSON (cJSON_ParseLines takes care of its workers). */
+CJSON_PUBLIC(cJSON_bool) cJSON_EnableNodeSlab(size_t nodes_per_page);
+CJSON_PUBLIC(cJSON_bool) cJSON_DisableNodeSlab(void);
+CJSON_PUBLIC(void) cJSON_GetNodeSlabStats(cJSON_SlabStats *stats);
+
+/* Allocation contexts: unlike cJSON_InitHooks, each context has its own allocator, so different parts of a
+ * program can use different allocators at the same time. A tree made through a context must be changed and
+ * deleted through the same context. The other functions allocate with the global hooks, so they must not be
+ * used to add keys, strings or items to a context tree (cJSON_AddItemToArray and the Detach functions are fine,
+ * an index keeps using the allocator it was made with). */
+/* Returns NULL if allocate or deallocate is missing. The hooks are copied. */
+CJSON_PUBLIC(cJSON_Context *) cJSON_Context_New(const cJSON_ContextHooks *hooks);
+/* Trees made through the context have to be deleted first. */
+CJSON_PUBLIC(void) cJSON_Context_Delete(cJSON_Context *context);
+/* Like cJSON_ParseWithLengthOpts, the error is reported through cJSON_GetErrorPtr. */
+CJSON_PUBLIC(cJSON *) cJSON_Context_Parse(cJSON_Context *context, const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* Like cJSON_Print/cJSON_PrintUnformatted, free the result with cJSON_Context_Free. */
+CJSON_PUBLIC(char *) cJSON_Context_Print(cJSON_Context *context, const cJSON *item, cJSON_bool format);
+CJSON_PUBLIC(void) cJSON_Context_Free(cJSON_Context *context, void *object);
+CJSON_PUBLIC(cJSON *) cJSON_Context_CreateNull(cJSON_Context *context);
+CJSON_PUBLIC(cJSON *) cJSON_Context_CreateBool(cJSON_Context *context, cJSON_bool boolean);
+CJSON_PUBLIC(cJSON *) cJSON_Context_CreateNumber(cJSON_Context *context, double num);
+CJSON_PUBLIC(cJSON *) cJSON_Context_CreateString(cJSON_Context *context, const char *string);
+CJSON_PUBLIC(cJSON *) cJSON_Context_CreateArray(cJSON_Context *context);
+CJSON_PUBLIC(cJSON *) cJSON_Context_CreateObject(cJSON_Context *context);
+/* Copies the key with the context's allocator. */
+CJSON_PUBLIC(cJSON_bool) cJSON_Context_AddItemToObject(cJSON_Context *context, cJSON *object, const char *string, cJSON *item);
+/* Duplicates any tree into the context. */
+CJSON_PUBLIC(cJSON *) cJSON_Context_Duplicate(cJSON_Context *context, const cJSON *item, cJSON_bool recurse);
+/* Like cJSON_IndexArray and cJSON_IndexObject, the index is allocated through the context. */
+CJSON_PUBLIC(cJSON_bool) cJSON_Context_IndexArray(cJSON_Context *context, cJSON *array);
+CJSON_PUBLIC(cJSON_bool) cJSON_Context_IndexObject(cJSON_Context *context, cJSON *object);
+/* Like cJSON_Compare, but wide objects are matched with scratch memory from the context. */
+CJSON_PUBLIC(cJSON_bool) cJSON_Context_Compare(cJSON_Context *context, const cJSON *a, const cJSON *b, cJSON_bool case_sensitive);
+/* Like cJSON_MemoizeHash, the memos are allocated through the context. */
+CJSON_PUBLIC(cJSON_hash) cJSON_Context_MemoizeHash(cJSON_Context *context, cJSON *item);
+/* Like cJSON_Delete for a tree of the context. */
+CJSON_PUBLIC(void) cJSON_Context_DeleteItem(cJSON_Context *context, cJSON *item);
+/* Like cJSON_EnableNodeSlab and friends for the nodes of the context, cJSON_Context_Delete frees the pages. */
+CJSON_PUBLIC(cJSON_bool) cJSON_Context_EnableNodeSlab(cJSON_Context *context, size_t nodes_per_page);
+CJSON_PUBLIC(cJSON_bool) cJSON_Context_DisableNodeSlab(cJSON_Context *context);
+CJSON_PUBLIC(void) cJSON_Context_GetNodeSlabStats(const cJSON_Context *context, cJSON_SlabStats *stats);
+
 #ifdef __cplusplus
 }
 #endif
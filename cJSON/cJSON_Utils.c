@@ -258,17 +258,15 @@ CJSON_PUBLIC(char *) cJSONUtils_FindPointerFromObjectTo(const cJSON * const obje
     return NULL;
 }
 
-/* non broken version of cJSON_GetArrayItem */
+/* cJSON_GetArrayItem with a size_t index, uses the array index if there is one */
 static cJSON *get_array_item(const cJSON *array, size_t item)
 {
-    cJSON *child = array ? array->child : NULL;
-    while ((child != NULL) && (item > 0))
+    if (item > (size_t)INT_MAX)
     {
-        item--;
-        child = child->next;
+        return NULL;
     }
 
-    return child;
+    return cJSON_GetArrayItem(array, (int)item);
 }
 
 static cJSON_bool decode_array_index_from_pointer(const unsigned char * const pointer, size_t * const index)
@@ -389,41 +387,9 @@ static void decode_pointer_inplace(unsigned char *string)
     decoded_string[0] = '\0';
 }
 
-/* non-broken cJSON_DetachItemFromArray */
 static cJSON *detach_item_from_array(cJSON *array, size_t which)
 {
-    cJSON *c = array->child;
-    while (c && (which > 0))
-    {
-        c = c->next;
-        which--;
-    }
-    if (!c)
-    {
-        /* item doesn't exist */
-        return NULL;
-    }
-    if (c != array->child)
-    {
-        /* not the first element */
-        c->prev->next = c->next;
-    }
-    if (c->next)
-    {
-        c->next->prev = c->prev;
-    }
-    if (c == array->child)
-    {
-        array->child = c->next;
-    }
-    else if (c->next == NULL)
-    {
-        array->child->prev = c->prev;
-    }
-    /* make sure the detached item doesn't point anywhere anymore */
-    c->prev = c->next = NULL;
-
-    return c;
+    return cJSON_DetachItemViaPointer(array, get_array_item(array, which));
 }
 
 /* detach an item at the given path */
@@ -594,14 +560,156 @@ static cJSON *sort_list(cJSON *list, const cJSON_bool case_sensitive)
 
 static void sort_object(cJSON * const object, const cJSON_bool case_sensitive)
 {
+    cJSON *tail = NULL;
+
     if (object == NULL)
     {
         return;
     }
     object->child = sort_list(object->child, case_sensitive);
+
+    /* the prev pointer of the first child points to the last one, appending relies on it */
+    tail = object->child;
+    while ((tail != NULL) && (tail->next != NULL))
+    {
+        tail = tail->next;
+    }
+    if (object->child != NULL)
+    {
+        object->child->prev = tail;
+    }
+}
+
+/* The members of an object in key order, collected into an array so the diffing functions can walk
+ * two objects side by side without sorting (and thereby modifying) the objects themselves. */
+typedef struct
+{
+    const cJSON **items;
+    size_t count;
+} object_members;
+
+/* stable bottom-up merge sort, members with the same key keep their order */
+static void sort_members(const cJSON **items, const cJSON **scratch, const size_t count, const cJSON_bool case_sensitive)
+{
+    const cJSON **source = items;
+    const cJSON **target = scratch;
+    size_t width = 0;
+
+    for (width = 1; width < count; width *= 2)
+    {
+        const cJSON **swap = NULL;
+        size_t start = 0;
+
+        for (start = 0; start < count; start += 2 * width)
+        {
+            size_t left = start;
+            size_t middle = ((count - start) > width) ? (start + width) : count;
+            size_t right = middle;
+            size_t end = ((count - middle) > width) ? (middle + width) : count;
+            size_t position = start;
+
+            while ((left < middle) && (right < end))
+            {
+                if (compare_strings((const unsigned char*)source[right]->string, (const unsigned char*)source[left]->string, case_sensitive) < 0)
+                {
+                    target[position++] = source[right++];
+                }
+                else
+                {
+                    target[position++] = source[left++];
+                }
+            }
+            while (left < middle)
+            {
+                target[position++] = source[left++];
+            }
+            while (right < end)
+            {
+                target[position++] = source[right++];
+            }
+        }
+
+        swap = source;
+        source = target;
+        target = swap;
+    }
+
+    if (source != items)
+    {
+        memcpy(items, source, count * sizeof(const cJSON*));
+    }
+}
+
+/* Returns false if memory runs out, release the members with free_object_members. */
+static cJSON_bool get_object_members(object_members * const members, const cJSON * const object, const cJSON_bool case_sensitive)
+{
+    const cJSON *child = NULL;
+    size_t index = 0;
+    cJSON_bool sorted = true;
+
+    members->items = NULL;
+    members->count = (size_t)cJSON_GetArraySize(object);
+    if (members->count == 0)
+    {
+        return true;
+    }
+
+    /* the second half is scratch space for the merge sort */
+    members->items = (const cJSON**)cJSON_malloc(2 * members->count * sizeof(const cJSON*));
+    if (members->items == NULL)
+    {
+        members->count = 0;
+        return false;
+    }
+
+    for (child = object->child; (child != NULL) && (index < members->count); child = child->next)
+    {
+        if ((index > 0) && (compare_strings((const unsigned char*)members->items[index - 1]->string, (const unsigned char*)child->string, case_sensitive) > 0))
+        {
+            sorted = false;
+        }
+        members->items[index++] = child;
+    }
+    members->count = index;
+
+    /* members that already are in order, like the ones of a sorted object, don't need sorting */
+    if (!sorted)
+    {
+        sort_members(members->items, members->items + members->count, members->count, case_sensitive);
+    }
+
+    return true;
 }
 
-static cJSON_bool compare_json(cJSON *a, cJSON *b, const cJSON_bool case_sensitive)
+static void free_object_members(object_members * const members)
+{
+    if (members->items != NULL)
+    {
+        cJSON_free((void*)members->items);
+        members->items = NULL;
+    }
+    members->count = 0;
+}
+
+/* checks if two objects have the same keys in the same order, the usual case when diffing two
+ * versions of a document, which allows pairing the members up without sorting them */
+static cJSON_bool same_key_order(const cJSON * const a, const cJSON * const b, const cJSON_bool case_sensitive)
+{
+    const cJSON *a_child = a->child;
+    const cJSON *b_child = b->child;
+
+    for (; (a_child != NULL) && (b_child != NULL); (void)(a_child = a_child->next), b_child = b_child->next)
+    {
+        if (compare_strings((const unsigned char*)a_child->string, (const unsigned char*)b_child->string, case_sensitive) != 0)
+        {
+            return false;
+        }
+    }
+
+    return (a_child == NULL) && (b_child == NULL);
+}
+
+static cJSON_bool compare_json(const cJSON *a, const cJSON *b, const cJSON_bool case_sensitive)
 {
     if ((a == NULL) || (b == NULL) || ((a->type & 0xFF) != (b->type & 0xFF)))
     {
@@ -653,34 +761,65 @@ static cJSON_bool compare_json(cJSON *a, cJSON *b, const cJSON_bool case_sensiti
             }
 
         case cJSON_Object:
-            sort_object(a, case_sensitive);
-            sort_object(b, case_sensitive);
-            for ((void)(a = a->child), b = b->child; (a != NULL) && (b != NULL); (void)(a = a->next), b = b->next)
+        {
+            object_members a_members;
+            object_members b_members;
+            cJSON_bool identical = true;
+            size_t index = 0;
+
+            /* object length mismatch */
+            if (cJSON_GetArraySize(a) != cJSON_GetArraySize(b))
             {
-                cJSON_bool identical = false;
-                /* compare object keys */
-                if (compare_strings((unsigned char*)a->string, (unsigned char*)b->string, case_sensitive))
-                {
-                    /* missing member */
-                    return false;
-                }
-                identical = compare_json(a, b, case_sensitive);
-                if (!identical)
+                return false;
+            }
+
+            if (same_key_order(a, b, case_sensitive))
+            {
+                for ((void)(a = a->child), b = b->child; (a != NULL) && (b != NULL); (void)(a = a->next), b = b->next)
                 {
-                    return false;
+                    if (!compare_json(a, b, case_sensitive))
+                    {
+                        return false;
+                    }
                 }
+
+                return true;
             }
 
-            /* object length mismatch (one of both children is not null) */
-            if ((a != NULL) || (b != NULL))
+            if (!get_object_members(&a_members, a, case_sensitive))
             {
                 return false;
             }
-            else
+            if (!get_object_members(&b_members, b, case_sensitive))
             {
-                return true;
+                free_object_members(&a_members);
+                return false;
+            }
+
+            for (index = 0; identical && (index < a_members.count) && (index < b_members.count); index++)
+            {
+                /* compare object keys */
+                if (compare_strings((const unsigned char*)a_members.items[index]->string, (const unsigned char*)b_members.items[index]->string, case_sensitive))
+                {
+                    /* missing member */
+                    identical = false;
+                }
+                else
+                {
+                    identical = compare_json(a_members.items[index], b_members.items[index], case_sensitive);
+                }
+            }
+            if (a_members.count != b_members.count)
+            {
+                identical = false;
             }
 
+            free_object_members(&a_members);
+            free_object_members(&b_members);
+
+            return identical;
+        }
+
         default:
             break;
     }
@@ -689,42 +828,16 @@ static cJSON_bool compare_json(cJSON *a, cJSON *b, const cJSON_bool case_sensiti
     return true;
 }
 
-/* non broken version of cJSON_InsertItemInArray */
+/* cJSON_InsertItemInArray that fails instead of appending when which is past the end */
 static cJSON_bool insert_item_in_array(cJSON *array, size_t which, cJSON *newitem)
 {
-    cJSON *child = array->child;
-    while (child && (which > 0))
-    {
-        child = child->next;
-        which--;
-    }
-    if (which > 0)
+    if ((which > (size_t)cJSON_GetArraySize(array)) || (which > (size_t)INT_MAX))
     {
         /* item is after the end of the array */
         return 0;
     }
-    if (child == NULL)
-    {
-        cJSON_AddItemToArray(array, newitem);
-        return 1;
-    }
 
-    /* insert into the linked list */
-    newitem->next = child;
-    newitem->prev = child->prev;
-    child->prev = newitem;
-
-    /* was it at the beginning */
-    if (child == array->child)
-    {
-        array->child = newitem;
-    }
-    else
-    {
-        newitem->prev->next = newitem;
-    }
-
-    return 1;
+    return cJSON_InsertItemInArray(array, (int)which, newitem);
 }
 
 static cJSON *get_object_item(const cJSON * const object, const char* name, const cJSON_bool case_sensitive)
@@ -783,11 +896,15 @@ static enum patch_operation decode_patch_operation(const cJSON * const patch, co
 /* overwrite and existing item with another one and free resources on the way */
 static void overwrite_item(cJSON * const root, const cJSON replacement)
 {
+    int memory_flags = 0;
+
     if (root == NULL)
     {
         return;
     }
 
+    /* first, the index of an array or object is kept in valuestring */
+    cJSON_InvalidateIndex(root);
     if (root->string != NULL)
     {
         cJSON_free(root->string);
@@ -801,7 +918,10 @@ static void overwrite_item(cJSON * const root, const cJSON replacement)
         cJSON_Delete(root->child);
     }
 
+    /* where the memory of root came from doesn't change */
+    memory_flags = root->type & cJSON_ArenaOwned;
     memcpy(root, &replacement, sizeof(cJSON));
+    root->type = (root->type & ~cJSON_ArenaOwned) | memory_flags;
 }
 
 static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_sensitive)
@@ -868,8 +988,11 @@ static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_
 
             overwrite_item(object, *value);
 
-            /* delete the duplicated value */
-            cJSON_free(value);
+            /* delete the duplicated value, its contents belong to object now */
+            value->child = NULL;
+            value->valuestring = NULL;
+            value->string = NULL;
+            cJSON_Delete(value);
             value = NULL;
 
             /* the string "value" isn't needed */
@@ -906,7 +1029,7 @@ static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_
     if ((opcode == MOVE) || (opcode == COPY))
     {
         cJSON *from = get_object_item(patch, "from", case_sensitive);
-        if (from == NULL)
+        if (!cJSON_IsString(from))
         {
             /* missing "from" for copy/move. */
             status = 4;
@@ -1138,7 +1261,485 @@ CJSON_PUBLIC(void) cJSONUtils_AddPatchToArray(cJSON * const array, const char *
     compose_patch(array, (const unsigned char*)operation, (const unsigned char*)path, NULL, value);
 }
 
-static void create_patches(cJSON * const patches, const unsigned char * const path, cJSON * const from, cJSON * const to, const cJSON_bool case_sensitive)
+static void create_patches(cJSON * const patches, const unsigned char * const path, const cJSON * const from, const cJSON * const to, const cJSON_bool case_sensitive, const cJSON_bool diff_arrays);
+
+/* What happens to an element of the part of two arrays that differs */
+#define ELEMENT_MATCHED 0 /* part of the longest common subsequence, stays */
+#define ELEMENT_PAIRED 1 /* changed in place, gets patches of its own */
+#define ELEMENT_MOVED 2 /* an equal element exists elsewhere in the other array */
+#define ELEMENT_CHANGED 3 /* removed from 'from' or added in 'to' */
+
+#define NO_PARTNER ((size_t)-1)
+
+typedef struct
+{
+    const cJSON **elements; /* 'from' elements followed by 'to' elements */
+    size_t *hashes; /* from cJSON_Hash */
+    size_t *partners; /* index of the corresponding element in the other array */
+    unsigned char *states;
+    size_t from_count;
+    size_t to_count;
+} array_diff;
+
+/* cJSON_Hash is exact, so elements that compare_json only finds close enough to be equal (numbers a rounding
+ * error apart, keys that differ in case) aren't matched up, they get patches of their own instead. */
+static cJSON_bool array_elements_equal(const array_diff * const diff, const size_t from_index, const size_t to_index, const cJSON_bool case_sensitive)
+{
+    const size_t to_position = diff->from_count + to_index;
+
+    return (diff->hashes[from_index] == diff->hashes[to_position]) && compare_json(diff->elements[from_index], diff->elements[to_position], case_sensitive);
+}
+
+static void match_array_elements(array_diff * const diff, const size_t from_index, const size_t to_index)
+{
+    diff->states[from_index] = ELEMENT_MATCHED;
+    diff->states[diff->from_count + to_index] = ELEMENT_MATCHED;
+    diff->partners[from_index] = to_index;
+    diff->partners[diff->from_count + to_index] = from_index;
+}
+
+/* Finds the longest common subsequence with Myers' algorithm and marks it as matched. Returns
+ * false, leaving every element unmatched, if more than CJSON_UTILS_ARRAY_DIFF_LIMIT insertions
+ * and deletions are needed or memory runs out. */
+static cJSON_bool find_common_elements(array_diff * const diff, const cJSON_bool case_sensitive)
+{
+    const long from_count = (long)diff->from_count;
+    const long to_count = (long)diff->to_count;
+    long limit = from_count + to_count;
+    long *v = NULL;
+    long *trace = NULL;
+    long d = 0;
+    long k = 0;
+    long x = 0;
+    long y = 0;
+    cJSON_bool found = false;
+
+    if (limit > (long)CJSON_UTILS_ARRAY_DIFF_LIMIT)
+    {
+        limit = (long)CJSON_UTILS_ARRAY_DIFF_LIMIT;
+    }
+
+    /* v[k] is the furthest x reached on diagonal k = x - y, trace keeps v after every step d */
+    v = (long*)cJSON_malloc((size_t)(2 * limit + 3) * sizeof(long));
+    trace = (long*)cJSON_malloc((size_t)((limit + 1) * (limit + 1)) * sizeof(long));
+    if ((v == NULL) || (trace == NULL))
+    {
+        goto cleanup;
+    }
+    memset(v, '\0', (size_t)(2 * limit + 3) * sizeof(long));
+    v += limit + 1;
+
+    for (d = 0; (d <= limit) && !found; d++)
+    {
+        for (k = -d; k <= d; k += 2)
+        {
+            if ((k == -d) || ((k != d) && (v[k - 1] < v[k + 1])))
+            {
+                /* step down, insert an element of 'to' */
+                x = v[k + 1];
+            }
+            else
+            {
+                /* step right, delete an element of 'from' */
+                x = v[k - 1] + 1;
+            }
+            y = x - k;
+            while ((x < from_count) && (y < to_count) && array_elements_equal(diff, (size_t)x, (size_t)y, case_sensitive))
+            {
+                x++;
+                y++;
+            }
+            v[k] = x;
+            if ((x >= from_count) && (y >= to_count))
+            {
+                found = true;
+                break;
+            }
+        }
+        memcpy(trace + (d * d), v - d, (size_t)(2 * d + 1) * sizeof(long));
+    }
+    if (!found)
+    {
+        goto cleanup;
+    }
+
+    /* walk back from the end and mark the diagonals (equal elements) on the way */
+    x = from_count;
+    y = to_count;
+    for (d = d - 1; d > 0; d--)
+    {
+        const long *previous = trace + ((d - 1) * (d - 1)) + (d - 1);
+        long previous_k = 0;
+        long start_x = 0;
+
+        k = x - y;
+        if ((k == -d) || ((k != d) && (previous[k - 1] < previous[k + 1])))
+        {
+            previous_k = k + 1;
+            start_x = previous[previous_k];
+        }
+        else
+        {
+            previous_k = k - 1;
+            start_x = previous[previous_k] + 1;
+        }
+        while ((x > start_x) && (y > (start_x - k)))
+        {
+            x--;
+            y--;
+            match_array_elements(diff, (size_t)x, (size_t)y);
+        }
+        x = previous[previous_k];
+        y = x - previous_k;
+    }
+    while ((x > 0) && (y > 0))
+    {
+        x--;
+        y--;
+        match_array_elements(diff, (size_t)x, (size_t)y);
+    }
+
+cleanup:
+    if (v != NULL)
+    {
+        cJSON_free(v - (limit + 1));
+    }
+    if (trace != NULL)
+    {
+        cJSON_free(trace);
+    }
+
+    return found;
+}
+
+/* Turns an element that was removed from one place and added at another into a move */
+static void find_moved_elements(array_diff * const diff, const cJSON_bool case_sensitive)
+{
+    size_t from_index = 0;
+    size_t to_index = 0;
+
+    for (to_index = 0; to_index < diff->to_count; to_index++)
+    {
+        const size_t to_position = diff->from_count + to_index;
+        if (diff->states[to_position] != ELEMENT_CHANGED)
+        {
+            continue;
+        }
+
+        for (from_index = 0; from_index < diff->from_count; from_index++)
+        {
+            if ((diff->states[from_index] == ELEMENT_CHANGED) && array_elements_equal(diff, from_index, to_index, case_sensitive))
+            {
+                diff->states[from_index] = ELEMENT_MOVED;
+                diff->states[to_position] = ELEMENT_MOVED;
+                diff->partners[from_index] = to_index;
+                diff->partners[to_position] = from_index;
+                break;
+            }
+        }
+    }
+}
+
+/* Between two matched elements, pairs up the removed elements of 'from' with the added elements
+ * of 'to' in order, so changed elements are patched instead of being replaced as a whole. */
+static void pair_changed_elements(array_diff * const diff)
+{
+    size_t from_index = 0;
+    size_t to_index = 0;
+
+    while ((from_index < diff->from_count) || (to_index < diff->to_count))
+    {
+        size_t from_end = from_index;
+        size_t to_end = to_index;
+
+        while ((from_end < diff->from_count) && (diff->states[from_end] != ELEMENT_MATCHED))
+        {
+            from_end++;
+        }
+        while ((to_end < diff->to_count) && (diff->states[diff->from_count + to_end] != ELEMENT_MATCHED))
+        {
+            to_end++;
+        }
+
+        for (;;)
+        {
+            while ((from_index < from_end) && (diff->states[from_index] != ELEMENT_CHANGED))
+            {
+                from_index++;
+            }
+            while ((to_index < to_end) && (diff->states[diff->from_count + to_index] != ELEMENT_CHANGED))
+            {
+                to_index++;
+            }
+            if ((from_index == from_end) || (to_index == to_end))
+            {
+                break;
+            }
+            diff->states[from_index] = ELEMENT_PAIRED;
+            diff->states[diff->from_count + to_index] = ELEMENT_PAIRED;
+            diff->partners[from_index] = to_index;
+            diff->partners[diff->from_count + to_index] = from_index;
+        }
+
+        /* skip the matched pair that ends this stretch */
+        from_index = from_end + 1;
+        to_index = to_end + 1;
+    }
+}
+
+static void compose_move_patch(cJSON * const patches, const unsigned char * const path, const size_t from_index, const size_t to_index)
+{
+    cJSON *patch = NULL;
+    unsigned char *full_path = (unsigned char*)cJSON_malloc(strlen((const char*)path) + 20 + sizeof("/"));
+
+    if (full_path == NULL)
+    {
+        return;
+    }
+    patch = cJSON_CreateObject();
+    if (patch == NULL)
+    {
+        cJSON_free(full_path);
+        return;
+    }
+    cJSON_AddItemToObject(patch, "op", cJSON_CreateString("move"));
+    sprintf((char*)full_path, "%s/%lu", (const char*)path, (unsigned long)from_index);
+    cJSON_AddItemToObject(patch, "from", cJSON_CreateString((const char*)full_path));
+    sprintf((char*)full_path, "%s/%lu", (const char*)path, (unsigned long)to_index);
+    cJSON_AddItemToObject(patch, "path", cJSON_CreateString((const char*)full_path));
+    cJSON_AddItemToArray(patches, patch);
+    cJSON_free(full_path);
+}
+
+static void remove_position(size_t * const positions, size_t * const count, const size_t index)
+{
+    memmove(positions + index, positions + index + 1, (*count - index - 1) * sizeof(size_t));
+    (*count)--;
+}
+
+static void insert_position(size_t * const positions, size_t * const count, const size_t index, const size_t value)
+{
+    memmove(positions + index + 1, positions + index, (*count - index) * sizeof(size_t));
+    positions[index] = value;
+    (*count)++;
+}
+
+/* Emits the patches that turn the differing part of 'from', which starts at offset in the array,
+ * into the one of 'to'. The array being patched is simulated in 'positions', holding the index of
+ * the 'from' element in every place, to know the index every operation has to use. */
+static void compose_array_patches(cJSON * const patches, const unsigned char * const path, const array_diff * const diff, size_t * const positions, const size_t offset, const cJSON_bool at_end, const cJSON_bool case_sensitive)
+{
+    unsigned char *new_path = (unsigned char*)cJSON_malloc(strlen((const char*)path) + 20 + sizeof("/")); /* Allow space for 64bit int. log10(2^64) = 20 */
+    size_t count = diff->from_count;
+    size_t current = 0;
+    size_t to_index = 0;
+    size_t i = 0;
+
+    if (new_path == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        positions[i] = i;
+    }
+
+    /* build the result from left to right, current is the place of the next element of 'to' */
+    for (to_index = 0; to_index < diff->to_count; to_index++)
+    {
+        const size_t to_position = diff->from_count + to_index;
+        const size_t partner = diff->partners[to_position];
+
+        switch (diff->states[to_position])
+        {
+            case ELEMENT_CHANGED:
+                if (at_end && (current == count))
+                {
+                    compose_patch(patches, (const unsigned char*)"add", path, (const unsigned char*)"-", diff->elements[to_position]);
+                }
+                else
+                {
+                    sprintf((char*)new_path, "%lu", (unsigned long)(offset + current));
+                    compose_patch(patches, (const unsigned char*)"add", path, new_path, diff->elements[to_position]);
+                }
+                insert_position(positions, &count, current, NO_PARTNER);
+                current++;
+                break;
+
+            case ELEMENT_MOVED:
+                i = 0;
+                while (positions[i] != partner)
+                {
+                    i++;
+                }
+                if (i < current)
+                {
+                    /* the element was passed over, the place of the target shifts down by its removal */
+                    compose_move_patch(patches, path, offset + i, offset + current - 1);
+                    remove_position(positions, &count, i);
+                    insert_position(positions, &count, current - 1, partner);
+                }
+                else
+                {
+                    if (i != current)
+                    {
+                        compose_move_patch(patches, path, offset + i, offset + current);
+                        remove_position(positions, &count, i);
+                        insert_position(positions, &count, current, partner);
+                    }
+                    current++;
+                }
+                break;
+
+            default:
+                /* remove what is in the way, elements that move further right later are passed over */
+                while (positions[current] != partner)
+                {
+                    if (diff->states[positions[current]] == ELEMENT_CHANGED)
+                    {
+                        sprintf((char*)new_path, "%lu", (unsigned long)(offset + current));
+                        compose_patch(patches, (const unsigned char*)"remove", path, new_path, NULL);
+                        remove_position(positions, &count, current);
+                    }
+                    else
+                    {
+                        current++;
+                    }
+                }
+                if (diff->states[to_position] == ELEMENT_PAIRED)
+                {
+                    sprintf((char*)new_path, "%s/%lu", (const char*)path, (unsigned long)(offset + current));
+                    create_patches(patches, new_path, diff->elements[partner], diff->elements[to_position], case_sensitive, true);
+                }
+                current++;
+                break;
+        }
+    }
+
+    /* remove leftover elements from 'from' that are not in 'to' */
+    sprintf((char*)new_path, "%lu", (unsigned long)(offset + current));
+    for (; current < count; count--)
+    {
+        compose_patch(patches, (const unsigned char*)"remove", path, new_path, NULL);
+    }
+
+    cJSON_free(new_path);
+}
+
+/* Only the part between the common head and tail of both arrays is diffed. Inside it the longest
+ * common subsequence stays where it is, equal elements that changed places are moved and the
+ * remaining elements between two kept ones are patched in pairs, the surplus removed or added. */
+static void create_array_patches(cJSON * const patches, const unsigned char * const path, const cJSON * const from, const cJSON * const to, const cJSON_bool case_sensitive)
+{
+    array_diff diff;
+    const cJSON *from_child = from->child;
+    const cJSON *to_child = to->child;
+    const cJSON *from_start = NULL;
+    const cJSON *to_start = NULL;
+    const cJSON *from_tail = NULL;
+    const cJSON *to_tail = NULL;
+    size_t *buffer = NULL;
+    size_t offset = 0;
+    size_t total = 0;
+    size_t i = 0;
+    cJSON_bool at_end = true;
+
+    memset(&diff, '\0', sizeof(diff));
+
+    /* skip the common head */
+    while ((from_child != NULL) && (to_child != NULL) && compare_json(from_child, to_child, case_sensitive))
+    {
+        from_child = from_child->next;
+        to_child = to_child->next;
+        offset++;
+    }
+    if ((from_child == NULL) && (to_child == NULL))
+    {
+        return;
+    }
+
+    /* and the common tail, the prev pointer of the first child points to the last one */
+    if ((from_child != NULL) && (to_child != NULL))
+    {
+        from_tail = from->child->prev;
+        to_tail = to->child->prev;
+        while ((from_tail != from_child->prev) && (to_tail != to_child->prev) && compare_json(from_tail, to_tail, case_sensitive))
+        {
+            from_tail = from_tail->prev;
+            to_tail = to_tail->prev;
+            at_end = false;
+        }
+    }
+
+    from_start = from_child;
+    to_start = to_child;
+    from_tail = (from_tail != NULL) ? from_tail->next : NULL;
+    to_tail = (to_tail != NULL) ? to_tail->next : NULL;
+    for (; from_child != from_tail; from_child = from_child->next)
+    {
+        diff.from_count++;
+    }
+    for (; to_child != to_tail; to_child = to_child->next)
+    {
+        diff.to_count++;
+    }
+    total = diff.from_count + diff.to_count;
+
+    diff.elements = (const cJSON**)cJSON_malloc(total * sizeof(const cJSON*));
+    /* hashes, partners and the simulated array that holds up to every element */
+    buffer = (size_t*)cJSON_malloc(3 * total * sizeof(size_t));
+    diff.states = (unsigned char*)cJSON_malloc(total);
+    if ((diff.elements == NULL) || (buffer == NULL) || (diff.states == NULL))
+    {
+        goto cleanup;
+    }
+    diff.hashes = buffer;
+    diff.partners = buffer + total;
+
+    from_child = from_start;
+    to_child = to_start;
+    for (i = 0; i < diff.from_count; (void)i++, from_child = from_child->next)
+    {
+        diff.elements[i] = from_child;
+    }
+    for (; i < total; (void)i++, to_child = to_child->next)
+    {
+        diff.elements[i] = to_child;
+    }
+    for (i = 0; i < total; i++)
+    {
+        diff.hashes[i] = (size_t)cJSON_Hash(diff.elements[i]);
+        diff.partners[i] = NO_PARTNER;
+    }
+    memset(diff.states, ELEMENT_CHANGED, total);
+
+    /* without a common subsequence the elements are paired by their index, like everything was changed in place */
+    if (find_common_elements(&diff, case_sensitive))
+    {
+        find_moved_elements(&diff, case_sensitive);
+    }
+    pair_changed_elements(&diff);
+
+    compose_array_patches(patches, path, &diff, buffer + (2 * total), offset, at_end, case_sensitive);
+
+cleanup:
+    if (diff.elements != NULL)
+    {
+        cJSON_free((void*)diff.elements);
+    }
+    if (buffer != NULL)
+    {
+        cJSON_free(buffer);
+    }
+    if (diff.states != NULL)
+    {
+        cJSON_free(diff.states);
+    }
+}
+
+/* diff_arrays selects create_array_patches, otherwise array elements are patched pairwise by index */
+static void create_patches(cJSON * const patches, const unsigned char * const path, const cJSON * const from, const cJSON * const to, const cJSON_bool case_sensitive, const cJSON_bool diff_arrays)
 {
     if ((from == NULL) || (to == NULL))
     {
@@ -1170,9 +1771,17 @@ static void create_patches(cJSON * const patches, const unsigned char * const pa
         case cJSON_Array:
         {
             size_t index = 0;
-            cJSON *from_child = from->child;
-            cJSON *to_child = to->child;
-            unsigned char *new_path = (unsigned char*)cJSON_malloc(strlen((const char*)path) + 20 + sizeof("/")); /* Allow space for 64bit int. log10(2^64) = 20 */
+            const cJSON *from_child = from->child;
+            const cJSON *to_child = to->child;
+            unsigned char *new_path = NULL;
+
+            if (diff_arrays)
+            {
+                create_array_patches(patches, path, from, to, case_sensitive);
+                return;
+            }
+
+            new_path = (unsigned char*)cJSON_malloc(strlen((const char*)path) + 20 + sizeof("/")); /* Allow space for 64bit int. log10(2^64) = 20 */
 
             /* generate patches for all array elements that exist in both "from" and "to" */
             for (index = 0; (from_child != NULL) && (to_child != NULL); (void)(from_child = from_child->next), (void)(to_child = to_child->next), index++)
@@ -1186,7 +1795,7 @@ static void create_patches(cJSON * const patches, const unsigned char * const pa
                     return;
                 }
                 sprintf((char*)new_path, "%s/%lu", path, (unsigned long)index); /* path of the current array element */
-                create_patches(patches, new_path, from_child, to_child, case_sensitive);
+                create_patches(patches, new_path, from_child, to_child, case_sensitive, false);
             }
 
             /* remove leftover elements from 'from' that are not in 'to' */
@@ -1214,16 +1823,26 @@ static void create_patches(cJSON * const patches, const unsigned char * const pa
 
         case cJSON_Object:
         {
-            cJSON *from_child = NULL;
-            cJSON *to_child = NULL;
-            sort_object(from, case_sensitive);
-            sort_object(to, case_sensitive);
+            object_members from_members;
+            object_members to_members;
+            size_t from_index = 0;
+            size_t to_index = 0;
+
+            if (!get_object_members(&from_members, from, case_sensitive))
+            {
+                return;
+            }
+            if (!get_object_members(&to_members, to, case_sensitive))
+            {
+                free_object_members(&from_members);
+                return;
+            }
 
-            from_child = from->child;
-            to_child = to->child;
             /* for all object values in the object with more of them */
-            while ((from_child != NULL) || (to_child != NULL))
+            while ((from_index < from_members.count) || (to_index < to_members.count))
             {
+                const cJSON *from_child = (from_index < from_members.count) ? from_members.items[from_index] : NULL;
+                const cJSON *to_child = (to_index < to_members.count) ? to_members.items[to_index] : NULL;
                 int diff;
                 if (from_child == NULL)
                 {
@@ -1235,41 +1854,44 @@ static void create_patches(cJSON * const patches, const unsigned char * const pa
                 }
                 else
                 {
-                    diff = compare_strings((unsigned char*)from_child->string, (unsigned char*)to_child->string, case_sensitive);
+                    diff = compare_strings((const unsigned char*)from_child->string, (const unsigned char*)to_child->string, case_sensitive);
                 }
 
                 if (diff == 0)
                 {
                     /* both object keys are the same */
                     size_t path_length = strlen((const char*)path);
-                    size_t from_child_name_length = pointer_encoded_length((unsigned char*)from_child->string);
+                    size_t from_child_name_length = pointer_encoded_length((const unsigned char*)from_child->string);
                     unsigned char *new_path = (unsigned char*)cJSON_malloc(path_length + from_child_name_length + sizeof("/"));
 
                     sprintf((char*)new_path, "%s/", path);
-                    encode_string_as_pointer(new_path + path_length + 1, (unsigned char*)from_child->string);
+                    encode_string_as_pointer(new_path + path_length + 1, (const unsigned char*)from_child->string);
 
                     /* create a patch for the element */
-                    create_patches(patches, new_path, from_child, to_child, case_sensitive);
+                    create_patches(patches, new_path, from_child, to_child, case_sensitive, diff_arrays);
                     cJSON_free(new_path);
 
-                    from_child = from_child->next;
-                    to_child = to_child->next;
+                    from_index++;
+                    to_index++;
                 }
                 else if (diff < 0)
                 {
                     /* object element doesn't exist in 'to' --> remove it */
-                    compose_patch(patches, (const unsigned char*)"remove", path, (unsigned char*)from_child->string, NULL);
+                    compose_patch(patches, (const unsigned char*)"remove", path, (const unsigned char*)from_child->string, NULL);
 
-                    from_child = from_child->next;
+                    from_index++;
                 }
                 else
                 {
                     /* object element doesn't exist in 'from' --> add it */
-                    compose_patch(patches, (const unsigned char*)"add", path, (unsigned char*)to_child->string, to_child);
+                    compose_patch(patches, (const unsigned char*)"add", path, (const unsigned char*)to_child->string, to_child);
 
-                    to_child = to_child->next;
+                    to_index++;
                 }
             }
+
+            free_object_members(&from_members);
+            free_object_members(&to_members);
             return;
         }
 
@@ -1278,7 +1900,37 @@ static void create_patches(cJSON * const patches, const unsigned char * const pa
     }
 }
 
-CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatches(cJSON * const from, cJSON * const to)
+CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatches(const cJSON * const from, const cJSON * const to)
+{
+    cJSON *patches = NULL;
+
+    if ((from == NULL) || (to == NULL))
+    {
+        return NULL;
+    }
+
+    patches = cJSON_CreateArray();
+    create_patches(patches, (const unsigned char*)"", from, to, false, false);
+
+    return patches;
+}
+
+CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatchesCaseSensitive(const cJSON * const from, const cJSON * const to)
+{
+    cJSON *patches = NULL;
+
+    if ((from == NULL) || (to == NULL))
+    {
+        return NULL;
+    }
+
+    patches = cJSON_CreateArray();
+    create_patches(patches, (const unsigned char*)"", from, to, true, false);
+
+    return patches;
+}
+
+CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatchesWithMoves(const cJSON * const from, const cJSON * const to)
 {
     cJSON *patches = NULL;
 
@@ -1288,12 +1940,12 @@ CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatches(cJSON * const from, cJSON * con
     }
 
     patches = cJSON_CreateArray();
-    create_patches(patches, (const unsigned char*)"", from, to, false);
+    create_patches(patches, (const unsigned char*)"", from, to, false, true);
 
     return patches;
 }
 
-CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatchesCaseSensitive(cJSON * const from, cJSON * const to)
+CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatchesWithMovesCaseSensitive(const cJSON * const from, const cJSON * const to)
 {
     cJSON *patches = NULL;
 
@@ -1303,7 +1955,7 @@ CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatchesCaseSensitive(cJSON * const from
     }
 
     patches = cJSON_CreateArray();
-    create_patches(patches, (const unsigned char*)"", from, to, true);
+    create_patches(patches, (const unsigned char*)"", from, to, true, true);
 
     return patches;
 }
@@ -1388,10 +2040,12 @@ CJSON_PUBLIC(cJSON *) cJSONUtils_MergePatchCaseSensitive(cJSON *target, const cJ
     return merge_patch(target, patch, true);
 }
 
-static cJSON *generate_merge_patch(cJSON * const from, cJSON * const to, const cJSON_bool case_sensitive)
+static cJSON *generate_merge_patch(const cJSON * const from, const cJSON * const to, const cJSON_bool case_sensitive)
 {
-    cJSON *from_child = NULL;
-    cJSON *to_child = NULL;
+    object_members from_members;
+    object_members to_members;
+    size_t from_index = 0;
+    size_t to_index = 0;
     cJSON *patch = NULL;
     if (to == NULL)
     {
@@ -1403,24 +2057,33 @@ static cJSON *generate_merge_patch(cJSON * const from, cJSON * const to, const c
         return cJSON_Duplicate(to, 1);
     }
 
-    sort_object(from, case_sensitive);
-    sort_object(to, case_sensitive);
-
-    from_child = from->child;
-    to_child = to->child;
     patch = cJSON_CreateObject();
     if (patch == NULL)
     {
         return NULL;
     }
-    while (from_child || to_child)
+    if (!get_object_members(&from_members, from, case_sensitive))
+    {
+        cJSON_Delete(patch);
+        return NULL;
+    }
+    if (!get_object_members(&to_members, to, case_sensitive))
     {
+        free_object_members(&from_members);
+        cJSON_Delete(patch);
+        return NULL;
+    }
+
+    while ((from_index < from_members.count) || (to_index < to_members.count))
+    {
+        const cJSON *from_child = (from_index < from_members.count) ? from_members.items[from_index] : NULL;
+        const cJSON *to_child = (to_index < to_members.count) ? to_members.items[to_index] : NULL;
         int diff;
         if (from_child != NULL)
         {
             if (to_child != NULL)
             {
-                diff = strcmp(from_child->string, to_child->string);
+                diff = compare_strings((const unsigned char*)from_child->string, (const unsigned char*)to_child->string, case_sensitive);
             }
             else
             {
@@ -1437,14 +2100,14 @@ static cJSON *generate_merge_patch(cJSON * const from, cJSON * const to, const c
             /* from has a value that to doesn't have -> remove */
             cJSON_AddItemToObject(patch, from_child->string, cJSON_CreateNull());
 
-            from_child = from_child->next;
+            from_index++;
         }
         else if (diff > 0)
         {
             /* to has a value that from doesn't have -> add to patch */
             cJSON_AddItemToObject(patch, to_child->string, cJSON_Duplicate(to_child, 1));
 
-            to_child = to_child->next;
+            to_index++;
         }
         else
         {
@@ -1456,10 +2119,13 @@ static cJSON *generate_merge_patch(cJSON * const from, cJSON * const to, const c
             }
 
             /* next key in the object */
-            from_child = from_child->next;
-            to_child = to_child->next;
+            from_index++;
+            to_index++;
         }
     }
+    free_object_members(&from_members);
+    free_object_members(&to_members);
+
     if (patch->child == NULL)
     {
         /* no patch generated */
@@ -1470,12 +2136,12 @@ static cJSON *generate_merge_patch(cJSON * const from, cJSON * const to, const c
     return patch;
 }
 
-CJSON_PUBLIC(cJSON *) cJSONUtils_GenerateMergePatch(cJSON * const from, cJSON * const to)
+CJSON_PUBLIC(cJSON *) cJSONUtils_GenerateMergePatch(const cJSON * const from, const cJSON * const to)
 {
     return generate_merge_patch(from, to, false);
 }
 
-CJSON_PUBLIC(cJSON *) cJSONUtils_GenerateMergePatchCaseSensitive(cJSON * const from, cJSON * const to)
+CJSON_PUBLIC(cJSON *) cJSONUtils_GenerateMergePatchCaseSensitive(const cJSON * const from, const cJSON * const to)
 {
     return generate_merge_patch(from, to, true);
 }
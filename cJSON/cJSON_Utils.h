@@ -34,10 +34,20 @@ extern "C"
 CJSON_PUBLIC(cJSON *) cJSONUtils_GetPointer(cJSON * const object, const char *pointer);
 CJSON_PUBLIC(cJSON *) cJSONUtils_GetPointerCaseSensitive(cJSON * const object, const char *pointer);
 
+/* Limits how many insertions and deletions cJSONUtils_GeneratePatchesWithMoves looks for to line up the
+ * elements of two arrays. Arrays that differ by more are patched element by element. */
+#ifndef CJSON_UTILS_ARRAY_DIFF_LIMIT
+#define CJSON_UTILS_ARRAY_DIFF_LIMIT 256
+#endif
+
 /* Implement RFC6902 (https://tools.ietf.org/html/rfc6902) JSON Patch spec. */
-/* NOTE: This modifies objects in 'from' and 'to' by sorting the elements by their key */
-CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatches(cJSON * const from, cJSON * const to);
-CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatchesCaseSensitive(cJSON * const from, cJSON * const to);
+/* 'from' and 'to' are only read, object members are paired up by key without reordering them. */
+CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatches(const cJSON * const from, const cJSON * const to);
+CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatchesCaseSensitive(const cJSON * const from, const cJSON * const to);
+/* Like cJSONUtils_GeneratePatches, but arrays are diffed with add, remove and move operations for
+ * inserted, deleted and moved elements instead of being patched pairwise by index. */
+CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatchesWithMoves(const cJSON * const from, const cJSON * const to);
+CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatchesWithMovesCaseSensitive(const cJSON * const from, const cJSON * const to);
 /* Utility for generating patch array entries. */
 CJSON_PUBLIC(void) cJSONUtils_AddPatchToArray(cJSON * const array, const char * const operation, const char * const path, const cJSON * const value);
 /* Returns 0 for success. */
@@ -70,9 +80,9 @@ CJSON_PUBLIC(int) cJSONUtils_ApplyPatchesCaseSensitive(cJSON * const object, con
 CJSON_PUBLIC(cJSON *) cJSONUtils_MergePatch(cJSON *target, const cJSON * const patch);
 CJSON_PUBLIC(cJSON *) cJSONUtils_MergePatchCaseSensitive(cJSON *target, const cJSON * const patch);
 /* generates a patch to move from -> to */
-/* NOTE: This modifies objects in 'from' and 'to' by sorting the elements by their key */
-CJSON_PUBLIC(cJSON *) cJSONUtils_GenerateMergePatch(cJSON * const from, cJSON * const to);
-CJSON_PUBLIC(cJSON *) cJSONUtils_GenerateMergePatchCaseSensitive(cJSON * const from, cJSON * const to);
+/* 'from' and 'to' are only read, like with cJSONUtils_GeneratePatches */
+CJSON_PUBLIC(cJSON *) cJSONUtils_GenerateMergePatch(const cJSON * const from, const cJSON * const to);
+CJSON_PUBLIC(cJSON *) cJSONUtils_GenerateMergePatchCaseSensitive(const cJSON * const from, const cJSON * const to);
 
 /* Given a root object and a target object, construct a pointer from one to the other. */
 CJSON_PUBLIC(char *) cJSONUtils_FindPointerFromObjectTo(const cJSON * const object, const cJSON * const target);